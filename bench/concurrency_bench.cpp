@@ -0,0 +1,255 @@
+// Thread pool, ID and UUID benchmarks.  The pool is measured against a
+// single mutex-guarded FIFO, the textbook design it replaces.
+
+#include <foundation/base/thread_pool.hpp>
+#include <foundation/uuid/id_allocator.hpp>
+#include <foundation/uuid/uuid.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <stdio.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace foundation;
+
+namespace {
+
+// The baseline: every Schedule and every dequeue takes one lock.
+class LockedQueuePool {
+ public:
+  explicit LockedQueuePool(size_t threads) : stopping_(false) {
+    for (size_t i = 0; i < threads; ++i) {
+      workers_.emplace_back([this] { Loop(); });
+    }
+  }
+
+  ~LockedQueuePool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopping_ = true;
+    }
+    wake_.notify_all();
+    for (size_t i = 0; i < workers_.size(); ++i) workers_[i].join();
+  }
+
+  void Schedule(std::function<void()> fn) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      queue_.push_back(std::move(fn));
+    }
+    wake_.notify_one();
+  }
+
+ private:
+  void Loop() {
+    for (;;) {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        wake_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+        if (queue_.empty()) return;
+        task = std::move(queue_.front());
+        queue_.pop_front();
+      }
+      task();
+    }
+  }
+
+  std::vector<std::thread> workers_;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::deque<std::function<void()> > queue_;
+  bool stopping_;
+};
+
+// Counts down to zero and wakes the waiter.
+class Latch {
+ public:
+  explicit Latch(int64_t count) : count_(count) {}
+
+  void CountDown() {
+    if (count_.fetch_sub(1) == 1) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      done_.notify_all();
+    }
+  }
+
+  void Wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this] { return count_.load() == 0; });
+  }
+
+ private:
+  std::atomic<int64_t> count_;
+  std::mutex mutex_;
+  std::condition_variable done_;
+};
+
+// A task tree: each task does a little work and spawns `fanout`
+// children until `depth` runs out -- the shape recursive parallel
+// algorithms produce.
+template <typename Pool>
+void Spawn(Pool* pool, Latch* latch, int depth, int fanout) {
+  volatile uint64_t sink = 0;
+  for (int i = 0; i < 32; ++i) sink = sink + i;
+  if (depth > 0) {
+    for (int i = 0; i < fanout; ++i) {
+      pool->Schedule([=] { Spawn(pool, latch, depth - 1, fanout); });
+    }
+  }
+  latch->CountDown();
+}
+
+int64_t TreeSize(int depth, int fanout) {
+  int64_t total = 0, level = 1;
+  for (int d = 0; d <= depth; ++d, level *= fanout) total += level;
+  return total;
+}
+
+template <typename Pool>
+void RunTaskTree(benchmark::State& state) {
+  Pool pool(state.range(0));
+  const int depth = 6, fanout = 4;
+  const int64_t tasks = TreeSize(depth, fanout);
+  for (auto _ : state) {
+    Latch latch(tasks);
+    pool.Schedule([&] { Spawn(&pool, &latch, depth, fanout); });
+    latch.Wait();
+  }
+  state.SetItemsProcessed(state.iterations() * tasks);
+}
+
+// Many tiny tasks submitted from outside the pool.
+template <typename Pool>
+void RunExternalSubmit(benchmark::State& state) {
+  Pool pool(state.range(0));
+  const int64_t tasks = 10000;
+  for (auto _ : state) {
+    Latch latch(tasks);
+    for (int64_t i = 0; i < tasks; ++i) {
+      pool.Schedule([&latch] { latch.CountDown(); });
+    }
+    latch.Wait();
+  }
+  state.SetItemsProcessed(state.iterations() * tasks);
+}
+
+void ThreadArgs(benchmark::internal::Benchmark* b) {
+  b->ArgName("threads")->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
+}
+
+}  // namespace
+
+static void BM_ThreadPool_TaskTree(benchmark::State& state) {
+  RunTaskTree<ThreadPool>(state);
+}
+BENCHMARK(BM_ThreadPool_TaskTree)->Apply(ThreadArgs);
+
+static void BM_ThreadPool_TaskTree_LockedQueue(benchmark::State& state) {
+  RunTaskTree<LockedQueuePool>(state);
+}
+BENCHMARK(BM_ThreadPool_TaskTree_LockedQueue)->Apply(ThreadArgs);
+
+static void BM_ThreadPool_ExternalSubmit(benchmark::State& state) {
+  RunExternalSubmit<ThreadPool>(state);
+}
+BENCHMARK(BM_ThreadPool_ExternalSubmit)->Apply(ThreadArgs);
+
+static void BM_ThreadPool_ExternalSubmit_LockedQueue(benchmark::State& state) {
+  RunExternalSubmit<LockedQueuePool>(state);
+}
+BENCHMARK(BM_ThreadPool_ExternalSubmit_LockedQueue)->Apply(ThreadArgs);
+
+static void BM_ThreadPool_ParallelFor(benchmark::State& state) {
+  ThreadPool pool(state.range(0));
+  std::vector<double> data(1 << 20, 1.0);
+  for (auto _ : state) {
+    pool.ParallelFor(0, data.size(), 1 << 14, [&](size_t b, size_t e) {
+      for (size_t i = b; i < e; ++i) data[i] = data[i] * 1.0000001 + 1e-9;
+    });
+  }
+  state.SetItemsProcessed(state.iterations() * data.size());
+}
+BENCHMARK(BM_ThreadPool_ParallelFor)->Apply(ThreadArgs);
+
+// IDs from 1..8 benchmark threads at once.
+static void BM_GetUuid(benchmark::State& state) {
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(getUuid());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_GetUuid)->ThreadRange(1, 8)->UseRealTime();
+
+static void BM_GetUuid_GlobalAtomic(benchmark::State& state) {
+  static std::atomic<uint64_t> next(1);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(next.fetch_add(1));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_GetUuid_GlobalAtomic)->ThreadRange(1, 8)->UseRealTime();
+
+static void BM_Uuid_GenerateV4(benchmark::State& state) {
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Uuid::GenerateV4());
+  }
+}
+BENCHMARK(BM_Uuid_GenerateV4)->ThreadRange(1, 8)->UseRealTime();
+
+static void BM_Uuid_GenerateV7(benchmark::State& state) {
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Uuid::GenerateV7());
+  }
+}
+BENCHMARK(BM_Uuid_GenerateV7)->ThreadRange(1, 8)->UseRealTime();
+
+// Baseline: a shared, locked std::mt19937_64.
+static void BM_Uuid_GenerateV4_Std(benchmark::State& state) {
+  static std::mutex mutex;
+  static std::mt19937_64 rng(42);
+  for (auto _ : state) {
+    std::lock_guard<std::mutex> lock(mutex);
+    const uint64_t high = rng(), low = rng();
+    benchmark::DoNotOptimize(Uuid((high & ~0xf000ULL) | 0x4000ULL,
+                                  (low >> 2) | 0x8000000000000000ULL));
+  }
+}
+BENCHMARK(BM_Uuid_GenerateV4_Std)->ThreadRange(1, 8)->UseRealTime();
+
+static void BM_Uuid_FormatParse(benchmark::State& state) {
+  const Uuid id = Uuid::GenerateV4();
+  char buffer[Uuid::kStringLength];
+  Uuid parsed;
+  for (auto _ : state) {
+    id.Format(buffer);
+    benchmark::DoNotOptimize(
+        Uuid::Parse(StringPiece(buffer, sizeof(buffer)), &parsed));
+  }
+}
+BENCHMARK(BM_Uuid_FormatParse);
+
+static void BM_Uuid_FormatParse_Std(benchmark::State& state) {
+  const Uuid id = Uuid::GenerateV4();
+  char buffer[Uuid::kStringLength + 1];
+  for (auto _ : state) {
+    const uint64_t h = id.high(), l = id.low();
+    snprintf(buffer, sizeof(buffer), "%08x-%04x-%04x-%04x-%012llx",
+             static_cast<unsigned>(h >> 32), static_cast<unsigned>((h >> 16) & 0xffff),
+             static_cast<unsigned>(h & 0xffff), static_cast<unsigned>(l >> 48),
+             static_cast<unsigned long long>(l & 0xffffffffffffULL));
+    unsigned a, b, c, d;
+    unsigned long long e;
+    benchmark::DoNotOptimize(
+        sscanf(buffer, "%8x-%4x-%4x-%4x-%12llx", &a, &b, &c, &d, &e));
+  }
+}
+BENCHMARK(BM_Uuid_FormatParse_Std);
@@ -0,0 +1,163 @@
+// map/filter (serial and parallel) and lazy pipelines against
+// std::transform / std::copy_if and hand-written loops.
+
+#include <foundation/base/functional.hpp>
+#include <foundation/base/lazy.hpp>
+#include <foundation/base/thread_pool.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <vector>
+
+using namespace foundation;
+
+namespace {
+
+struct Record {
+  uint64_t id;
+  double score;
+  int32_t flags;
+};
+
+std::vector<Record> Records(size_t n) {
+  std::vector<Record> records(n);
+  for (size_t i = 0; i < n; ++i) {
+    records[i].id = i;
+    records[i].score = static_cast<double>((i * 2654435761u) % 1000) / 10.0;
+    records[i].flags = static_cast<int32_t>(i % 7);
+  }
+  return records;
+}
+
+// Enough arithmetic per element that parallelism can pay.
+double Weigh(const Record& r) {
+  double x = r.score;
+  for (int i = 0; i < 8; ++i) x = x * 0.5 + static_cast<double>(r.id & 15);
+  return x;
+}
+
+bool Keep(const Record& r) {
+  return r.flags != 3 && r.score > 20.0;
+}
+
+// One pool per thread count, shared across benchmarks.
+ThreadPool* PoolWith(int threads) {
+  static std::map<int, std::unique_ptr<ThreadPool> > pools;
+  std::unique_ptr<ThreadPool>& pool = pools[threads];
+  if (!pool) pool.reset(new ThreadPool(threads));
+  return pool.get();
+}
+
+void ParallelArgs(benchmark::internal::Benchmark* b) {
+  for (int64_t n : {1 << 12, 1 << 16, 1 << 20}) {
+    for (int64_t threads : {1, 2, 4, 8}) b->Args({n, threads});
+  }
+  b->ArgNames({"n", "threads"})->UseRealTime();
+}
+
+}  // namespace
+
+static void BM_Map(benchmark::State& state) {
+  const std::vector<Record> records = Records(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(map(Weigh, records));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Map)->RangeMultiplier(16)->Range(1 << 8, 1 << 20);
+
+static void BM_Map_Std(benchmark::State& state) {
+  const std::vector<Record> records = Records(state.range(0));
+  for (auto _ : state) {
+    std::vector<double> out;
+    std::transform(records.begin(), records.end(), std::back_inserter(out), Weigh);
+    benchmark::DoNotOptimize(out);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Map_Std)->RangeMultiplier(16)->Range(1 << 8, 1 << 20);
+
+static void BM_Map_Parallel(benchmark::State& state) {
+  const std::vector<Record> records = Records(state.range(0));
+  execution::parallel_policy policy;
+  policy.pool = PoolWith(static_cast<int>(state.range(1)));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(map(policy, Weigh, records));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Map_Parallel)->Apply(ParallelArgs);
+
+static void BM_Filter(benchmark::State& state) {
+  const std::vector<Record> records = Records(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(filter(Keep, records));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Filter)->RangeMultiplier(16)->Range(1 << 8, 1 << 20);
+
+static void BM_Filter_Std(benchmark::State& state) {
+  const std::vector<Record> records = Records(state.range(0));
+  for (auto _ : state) {
+    std::vector<Record> out;
+    std::copy_if(records.begin(), records.end(), std::back_inserter(out), Keep);
+    benchmark::DoNotOptimize(out);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Filter_Std)->RangeMultiplier(16)->Range(1 << 8, 1 << 20);
+
+static void BM_Filter_Parallel(benchmark::State& state) {
+  const std::vector<Record> records = Records(state.range(0));
+  execution::parallel_policy policy;
+  policy.pool = PoolWith(static_cast<int>(state.range(1)));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(filter(policy, Keep, records));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Filter_Parallel)->Apply(ParallelArgs);
+
+// filter(map(...)): eager stages, lazy pipeline, and the loop one would
+// write by hand.
+static void BM_Pipeline_Eager(benchmark::State& state) {
+  const std::vector<Record> records = Records(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        filter([](double w) { return w > 20.0; }, map(Weigh, records)));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Pipeline_Eager)->RangeMultiplier(16)->Range(1 << 8, 1 << 20);
+
+static void BM_Pipeline_Lazy(benchmark::State& state) {
+  const std::vector<Record> records = Records(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        (records | lazy::map(Weigh) | lazy::filter([](double w) { return w > 20.0; }))
+            .collect());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Pipeline_Lazy)->RangeMultiplier(16)->Range(1 << 8, 1 << 20);
+
+static void BM_Pipeline_Std(benchmark::State& state) {
+  const std::vector<Record> records = Records(state.range(0));
+  for (auto _ : state) {
+    std::vector<double> out;
+    for (const Record& r : records) {
+      const double w = Weigh(r);
+      if (w > 20.0) out.push_back(w);
+    }
+    benchmark::DoNotOptimize(out);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Pipeline_Std)->RangeMultiplier(16)->Range(1 << 8, 1 << 20);
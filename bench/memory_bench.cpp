@@ -0,0 +1,106 @@
+// Memory benchmarks: Arena, arena-backed string building and interning,
+// against the heap and std::unordered_set.
+
+#include <foundation/base/arena.hpp>
+#include <foundation/strings/arena_strcat.hpp>
+#include <foundation/strings/intern.hpp>
+#include <foundation/strings/strcat.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+using namespace foundation;
+
+namespace {
+
+std::vector<std::string> Keys(size_t n) {
+  std::vector<std::string> keys(n);
+  for (size_t i = 0; i < n; ++i) {
+    keys[i] = "metric.name." + std::to_string(i % 4096);
+  }
+  return keys;
+}
+
+}  // namespace
+
+// A request's worth of small allocations, then release everything.
+static void BM_Arena_SmallAllocations(benchmark::State& state) {
+  Arena arena;
+  for (auto _ : state) {
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      benchmark::DoNotOptimize(arena.Allocate(24 + (i & 63)));
+    }
+    arena.Reset();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Arena_SmallAllocations)->RangeMultiplier(8)->Range(8, 1 << 15);
+
+static void BM_Arena_SmallAllocations_Std(benchmark::State& state) {
+  std::vector<char*> blocks(state.range(0));
+  for (auto _ : state) {
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      blocks[i] = new char[24 + (i & 63)];
+      benchmark::DoNotOptimize(blocks[i]);
+    }
+    for (int64_t i = 0; i < state.range(0); ++i) delete[] blocks[i];
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Arena_SmallAllocations_Std)->RangeMultiplier(8)->Range(8, 1 << 15);
+
+static void BM_ArenaStrCat(benchmark::State& state) {
+  Arena arena;
+  for (auto _ : state) {
+    for (int i = 0; i < 64; ++i) {
+      benchmark::DoNotOptimize(ArenaStrCat(&arena, "user:", i, ":session:", 4242));
+    }
+    arena.Reset();
+  }
+  state.SetItemsProcessed(state.iterations() * 64);
+}
+BENCHMARK(BM_ArenaStrCat);
+
+static void BM_ArenaStrCat_Std(benchmark::State& state) {
+  for (auto _ : state) {
+    for (int i = 0; i < 64; ++i) {
+      benchmark::DoNotOptimize("user:" + std::to_string(i) + ":session:" +
+                               std::to_string(4242));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * 64);
+}
+BENCHMARK(BM_ArenaStrCat_Std);
+
+// Interning a stream of mostly repeated keys, from 1..8 threads.
+static void BM_Intern(benchmark::State& state) {
+  static InternPool* pool = new InternPool();
+  const std::vector<std::string> keys = Keys(state.range(0));
+  for (auto _ : state) {
+    for (size_t i = 0; i < keys.size(); ++i) {
+      benchmark::DoNotOptimize(pool->Intern(keys[i]));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Intern)->Arg(1 << 14)->ThreadRange(1, 8)->UseRealTime();
+
+// Baseline: a mutex-guarded std::unordered_set<std::string>.
+static void BM_Intern_Std(benchmark::State& state) {
+  static std::mutex* mutex = new std::mutex;
+  static std::unordered_set<std::string>* set = new std::unordered_set<std::string>;
+  const std::vector<std::string> keys = Keys(state.range(0));
+  for (auto _ : state) {
+    for (size_t i = 0; i < keys.size(); ++i) {
+      std::lock_guard<std::mutex> lock(*mutex);
+      benchmark::DoNotOptimize(&*set->insert(keys[i]).first);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Intern_Std)->Arg(1 << 14)->ThreadRange(1, 8)->UseRealTime();
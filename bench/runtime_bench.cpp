@@ -0,0 +1,294 @@
+// Event loop, timer, logger and metrics hot paths.
+
+#include <foundation/base/event_loop.hpp>
+#include <foundation/base/metrics.hpp>
+#include <foundation/datetime/timer.hpp>
+#include <foundation/logger/async_file_logger.hpp>
+#include <foundation/logger/logger.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Discards everything, so the logger benchmarks measure the dispatch and
+// formatting rather than a device.
+class NullBuffer : public std::streambuf {
+ protected:
+  int overflow(int c) override { return c; }
+  std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
+
+}  // namespace
+
+// UpdateTimers() over n pending timers that are not yet due.  The timer
+// list only grows, so each size tops it up to n.
+static void BM_UpdateTimers(benchmark::State& state) {
+  static int64_t registered = 0;
+  for (; registered < state.range(0); ++registered) {
+    AddTimer(1e9f, TimerType::ONE_SHOT, [] {});
+  }
+  for (auto _ : state) {
+    UpdateTimers();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_UpdateTimers)->RangeMultiplier(8)->Range(8, 1 << 15);
+
+// Baseline: the same expiry scan over a plain array of deadlines.
+static void BM_UpdateTimers_Std(benchmark::State& state) {
+  std::vector<time_t> deadlines(state.range(0), time(NULL) + 1000000000);
+  for (auto _ : state) {
+    const time_t now = time(NULL);
+    int64_t due = 0;
+    for (size_t i = 0; i < deadlines.size(); ++i) due += deadlines[i] <= now;
+    benchmark::DoNotOptimize(due);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_UpdateTimers_Std)->RangeMultiplier(8)->Range(8, 1 << 15);
+
+// Another thread Post()s a batch of tasks to a running loop, then Stop()s
+// it and waits for Run() to return, which the loop thread calls again at
+// once.  Every Post() and Stop() has to wake the loop, so this also
+// checks that no wake-up is lost: if one is, the benchmark hangs.
+static void BM_EventLoop_PostAndStop(benchmark::State& state) {
+  foundation::EventLoop loop;
+  std::atomic<int64_t> ran(0);
+  std::atomic<int64_t> runs(0);
+  std::atomic<bool> finished(false);
+  std::thread runner([&] {
+    while (!finished.load()) {
+      loop.Run();
+      runs.fetch_add(1);
+    }
+  });
+  int64_t posted = 0;
+  int64_t stops = 0;
+  for (auto _ : state) {
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      loop.Post([&ran] { ran.fetch_add(1, std::memory_order_relaxed); });
+    }
+    posted += state.range(0);
+    loop.Stop();
+    ++stops;
+    while (ran.load() < posted || runs.load() < stops) {
+      std::this_thread::yield();
+    }
+  }
+  finished.store(true);
+  loop.Stop();
+  runner.join();
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_EventLoop_PostAndStop)->Arg(1)->Arg(200)->UseRealTime();
+
+// Baseline: a worker thread draining a mutex and condition variable queue.
+static void BM_EventLoop_PostAndStop_Std(benchmark::State& state) {
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::deque<std::function<void()> > queue;
+  bool finished = false;
+  std::atomic<int64_t> ran(0);
+  std::thread worker([&] {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+      wake.wait(lock, [&] { return finished || !queue.empty(); });
+      if (queue.empty()) return;
+      std::function<void()> task = std::move(queue.front());
+      queue.pop_front();
+      lock.unlock();
+      task();
+      lock.lock();
+    }
+  });
+  int64_t posted = 0;
+  for (auto _ : state) {
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back(
+            [&ran] { ran.fetch_add(1, std::memory_order_relaxed); });
+      }
+      wake.notify_one();
+    }
+    posted += state.range(0);
+    while (ran.load() < posted) {
+      std::this_thread::yield();
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    finished = true;
+  }
+  wake.notify_one();
+  worker.join();
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_EventLoop_PostAndStop_Std)->Arg(1)->Arg(200)->UseRealTime();
+
+static void BM_SendToLogger(benchmark::State& state) {
+  NullBuffer buffer;
+  std::ostream stream(&buffer);
+  BasicLogger logger(stream);
+  ClearLoggers();
+  RegisterLogger(&logger, 0);
+  const std::string line(state.range(0), 'x');
+  for (auto _ : state) {
+    SendToLogger(1, line);
+  }
+  ClearLoggers();
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SendToLogger)->RangeMultiplier(8)->Range(16, 4096);
+
+static void BM_SendToLogger_Std(benchmark::State& state) {
+  NullBuffer buffer;
+  std::ostream stream(&buffer);
+  const std::string line(state.range(0), 'x');
+  for (auto _ : state) {
+    stream << line;
+    stream.flush();
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SendToLogger_Std)->RangeMultiplier(8)->Range(16, 4096);
+
+static void BM_Log_Formatted(benchmark::State& state) {
+  NullBuffer buffer;
+  std::ostream stream(&buffer);
+  BasicLogger logger(stream);
+  ClearLoggers();
+  RegisterLogger(&logger, 0);
+  int i = 0;
+  for (auto _ : state) {
+    Log(1, "request %d finished in %d us with status %s", ++i, 1234, "OK");
+  }
+  ClearLoggers();
+}
+BENCHMARK(BM_Log_Formatted);
+
+// Sustained logging to a file.  Arg 0 picks io_uring, 1 the pwritev
+// fallback.  Each iteration writes 16 MiB of lines, twice what the
+// buffers hold, and then Flush()es, all of it timed, so this is
+// end-to-end throughput rather than just the producer side.
+static const size_t kLogBatchBytes = 16 << 20;
+
+static void BM_AsyncFileLogger_Write(benchmark::State& state) {
+  char path[] = "/tmp/foundation_bench_XXXXXX";
+  close(mkstemp(path));
+  AsyncFileLogger::Options options;
+  options.backend = state.range(0) == 0 ? AsyncFileLogger::IO_URING
+                                        : AsyncFileLogger::PWRITEV;
+  std::string line(state.range(1), 'x');
+  line.back() = '\n';
+  const size_t lines = kLogBatchBytes / line.size();
+  {
+    AsyncFileLogger logger(path, options);
+    for (auto _ : state) {
+      for (size_t i = 0; i < lines; ++i) {
+        logger.write(line);
+      }
+      logger.Flush();
+    }
+  }
+  unlink(path);
+  state.SetBytesProcessed(state.iterations() * lines * line.size());
+}
+BENCHMARK(BM_AsyncFileLogger_Write)
+    ->ArgsProduct({{0, 1}, {128, 1024}})
+    ->UseRealTime();
+
+// Baseline: an ofstream written and flushed in the calling thread, the
+// same batch per iteration.
+static void BM_AsyncFileLogger_Write_Std(benchmark::State& state) {
+  char path[] = "/tmp/foundation_bench_XXXXXX";
+  close(mkstemp(path));
+  std::string line(state.range(1), 'x');
+  line.back() = '\n';
+  const size_t lines = kLogBatchBytes / line.size();
+  {
+    std::ofstream out(path);
+    for (auto _ : state) {
+      for (size_t i = 0; i < lines; ++i) {
+        out << line;
+      }
+      out.flush();
+    }
+  }
+  unlink(path);
+  state.SetBytesProcessed(state.iterations() * lines * line.size());
+}
+BENCHMARK(BM_AsyncFileLogger_Write_Std)
+    ->ArgsProduct({{0}, {128, 1024}})
+    ->UseRealTime();
+
+static void BM_Metrics_CounterIncrement(benchmark::State& state) {
+  static foundation::metrics::Counter* counter =
+      foundation::metrics::Registry::Default()->GetCounter(
+          "bench_counter_total", "Benchmark counter.");
+  for (auto _ : state) {
+    counter->Increment();
+  }
+}
+BENCHMARK(BM_Metrics_CounterIncrement)->ThreadRange(1, 8);
+
+// Baseline: one atomic shared by every thread.
+static void BM_Metrics_CounterIncrement_Std(benchmark::State& state) {
+  static std::atomic<uint64_t> counter(0);
+  for (auto _ : state) {
+    counter.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+BENCHMARK(BM_Metrics_CounterIncrement_Std)->ThreadRange(1, 8);
+
+static void BM_Metrics_HistogramObserve(benchmark::State& state) {
+  static foundation::metrics::Histogram* histogram =
+      foundation::metrics::Registry::Default()->GetHistogram(
+          "bench_latency_us", "Benchmark histogram.");
+  uint64_t v = 1;
+  for (auto _ : state) {
+    histogram->Observe(v);
+    v = v * 6364136223846793005ULL + 1442695040888963407ULL;
+    v >>= 44;
+  }
+}
+BENCHMARK(BM_Metrics_HistogramObserve)->ThreadRange(1, 8);
+
+// Scraping a registry of 100 counters and 10 busy histograms.
+static void BM_Metrics_WritePrometheusText(benchmark::State& state) {
+  foundation::metrics::Registry registry;
+  for (int i = 0; i < 100; ++i) {
+    registry.GetCounter("requests_total", "Requests.",
+                        "shard=\"" + std::to_string(i) + "\"")
+        ->Increment(i * 1000);
+  }
+  for (int i = 0; i < 10; ++i) {
+    foundation::metrics::Histogram* h = registry.GetHistogram(
+        "latency_us", "Latency.", "shard=\"" + std::to_string(i) + "\"");
+    for (uint64_t v = 1; v < (1 << 20); v = v * 5 / 4 + 1) h->Observe(v);
+  }
+  std::string out;
+  for (auto _ : state) {
+    out.clear();
+    registry.WritePrometheusText(&out);
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetBytesProcessed(state.iterations() * out.size());
+}
+BENCHMARK(BM_Metrics_WritePrometheusText);
@@ -0,0 +1,753 @@
+// String module benchmarks: StrCat, StrJoin, split, StringPiece search,
+// ASCII, numbers, hashing, UTF-8, hex/base64 and escaping, each against
+// the std:: way of doing it.
+
+#include <foundation/strings/ascii_ctype.hpp>
+#include <foundation/strings/charset.hpp>
+#include <foundation/strings/escaping.hpp>
+#include <foundation/strings/hash.hpp>
+#include <foundation/strings/join.hpp>
+#include <foundation/strings/numbers.hpp>
+#include <foundation/strings/split.hpp>
+#include <foundation/strings/strcat.hpp>
+#include <foundation/strings/stringpiece.hpp>
+#include <foundation/strings/utf8.hpp>
+#include <foundation/strings/utils.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <algorithm>
+#include <codecvt>
+#include <cctype>
+#include <functional>
+#include <locale>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+using namespace foundation;
+
+namespace {
+
+std::string RandomText(size_t n, uint32_t seed = 42) {
+  std::mt19937 rng(seed);
+  std::string s(n, ' ');
+  for (size_t i = 0; i < n; ++i) {
+    s[i] = static_cast<char>('a' + rng() % 26);
+  }
+  return s;
+}
+
+// "field0,field1,..." totalling about n bytes.
+std::string CsvLine(size_t n) {
+  std::string s;
+  for (int i = 0; s.size() < n; ++i) {
+    if (!s.empty()) s += ',';
+    s += "field" + std::to_string(i);
+  }
+  return s;
+}
+
+void SetBytes(benchmark::State& state, size_t bytes_per_iteration) {
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(bytes_per_iteration));
+}
+
+}  // namespace
+
+// ----------------------------------------------------------------------
+// StrCat / StrAppend
+// ----------------------------------------------------------------------
+
+static void BM_StrCat_Mixed(benchmark::State& state) {
+  const std::string key = "request";
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(StrCat(key, ":", 12345, "/", "status", "=", 200));
+  }
+}
+BENCHMARK(BM_StrCat_Mixed);
+
+static void BM_StrCat_Mixed_Std(benchmark::State& state) {
+  const std::string key = "request";
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(key + ":" + std::to_string(12345) + "/" +
+                             "status" + "=" + std::to_string(200));
+  }
+}
+BENCHMARK(BM_StrCat_Mixed_Std);
+
+static void BM_StrCat_Mixed_Ostringstream(benchmark::State& state) {
+  const std::string key = "request";
+  for (auto _ : state) {
+    std::ostringstream os;
+    os << key << ":" << 12345 << "/" << "status" << "=" << 200;
+    benchmark::DoNotOptimize(os.str());
+  }
+}
+BENCHMARK(BM_StrCat_Mixed_Ostringstream);
+
+static void BM_StrAppend_Pieces(benchmark::State& state) {
+  const std::string piece = RandomText(state.range(0));
+  for (auto _ : state) {
+    std::string out;
+    for (int i = 0; i < 16; ++i) StrAppend(&out, piece, ",", piece);
+    benchmark::DoNotOptimize(out);
+  }
+  SetBytes(state, 16 * (2 * piece.size() + 1));
+}
+BENCHMARK(BM_StrAppend_Pieces)->RangeMultiplier(8)->Range(8, 4096);
+
+static void BM_StrAppend_Pieces_Std(benchmark::State& state) {
+  const std::string piece = RandomText(state.range(0));
+  for (auto _ : state) {
+    std::string out;
+    for (int i = 0; i < 16; ++i) {
+      out += piece;
+      out += ",";
+      out += piece;
+    }
+    benchmark::DoNotOptimize(out);
+  }
+  SetBytes(state, 16 * (2 * piece.size() + 1));
+}
+BENCHMARK(BM_StrAppend_Pieces_Std)->RangeMultiplier(8)->Range(8, 4096);
+
+// ----------------------------------------------------------------------
+// StrJoin / repeat
+// ----------------------------------------------------------------------
+
+static void BM_StrJoin_Strings(benchmark::State& state) {
+  std::vector<std::string> parts(state.range(0));
+  for (size_t i = 0; i < parts.size(); ++i) parts[i] = RandomText(12, i);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(StrJoin(parts, ", "));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_StrJoin_Strings)->RangeMultiplier(8)->Range(8, 32768);
+
+static void BM_StrJoin_Strings_Std(benchmark::State& state) {
+  std::vector<std::string> parts(state.range(0));
+  for (size_t i = 0; i < parts.size(); ++i) parts[i] = RandomText(12, i);
+  for (auto _ : state) {
+    std::string out;
+    for (size_t i = 0; i < parts.size(); ++i) {
+      if (i != 0) out += ", ";
+      out += parts[i];
+    }
+    benchmark::DoNotOptimize(out);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_StrJoin_Strings_Std)->RangeMultiplier(8)->Range(8, 32768);
+
+static void BM_StrJoin_Ints(benchmark::State& state) {
+  std::vector<int> values(state.range(0));
+  for (size_t i = 0; i < values.size(); ++i) values[i] = static_cast<int>(i * 7919);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(StrJoin(values, ","));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_StrJoin_Ints)->RangeMultiplier(8)->Range(8, 32768);
+
+static void BM_StrJoin_Ints_Ostringstream(benchmark::State& state) {
+  std::vector<int> values(state.range(0));
+  for (size_t i = 0; i < values.size(); ++i) values[i] = static_cast<int>(i * 7919);
+  for (auto _ : state) {
+    std::ostringstream os;
+    for (size_t i = 0; i < values.size(); ++i) {
+      if (i != 0) os << ',';
+      os << values[i];
+    }
+    benchmark::DoNotOptimize(os.str());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_StrJoin_Ints_Ostringstream)->RangeMultiplier(8)->Range(8, 32768);
+
+static void BM_Repeat(benchmark::State& state) {
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(repeat(state.range(0), "abc"));
+  }
+  SetBytes(state, 3 * state.range(0));
+}
+BENCHMARK(BM_Repeat)->RangeMultiplier(16)->Range(16, 1 << 20);
+
+static void BM_Repeat_Std(benchmark::State& state) {
+  for (auto _ : state) {
+    std::string out;
+    for (int64_t i = 0; i < state.range(0); ++i) out += "abc";
+    benchmark::DoNotOptimize(out);
+  }
+  SetBytes(state, 3 * state.range(0));
+}
+BENCHMARK(BM_Repeat_Std)->RangeMultiplier(16)->Range(16, 1 << 20);
+
+// ----------------------------------------------------------------------
+// split / StrSplit
+// ----------------------------------------------------------------------
+
+static void BM_Split_Legacy(benchmark::State& state) {
+  const std::string line = CsvLine(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(split(line, ","));
+  }
+  SetBytes(state, line.size());
+}
+BENCHMARK(BM_Split_Legacy)->RangeMultiplier(8)->Range(64, 1 << 18);
+
+static void BM_StrSplit_Lazy(benchmark::State& state) {
+  const std::string line = CsvLine(state.range(0));
+  for (auto _ : state) {
+    size_t total = 0;
+    for (StringPiece field : StrSplit(line, ',')) total += field.size();
+    benchmark::DoNotOptimize(total);
+  }
+  SetBytes(state, line.size());
+}
+BENCHMARK(BM_StrSplit_Lazy)->RangeMultiplier(8)->Range(64, 1 << 18);
+
+static void BM_StrSplit_Lazy_Std(benchmark::State& state) {
+  const std::string line = CsvLine(state.range(0));
+  for (auto _ : state) {
+    std::istringstream in(line);
+    std::string field;
+    size_t total = 0;
+    while (std::getline(in, field, ',')) total += field.size();
+    benchmark::DoNotOptimize(total);
+  }
+  SetBytes(state, line.size());
+}
+BENCHMARK(BM_StrSplit_Lazy_Std)->RangeMultiplier(8)->Range(64, 1 << 18);
+
+// ----------------------------------------------------------------------
+// StringPiece search
+// ----------------------------------------------------------------------
+
+static void BM_StringPiece_Find(benchmark::State& state) {
+  const std::string haystack = RandomText(state.range(0)) + "needle_xyz";
+  const StringPiece sp(haystack);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(sp.find("needle_xyz"));
+  }
+  SetBytes(state, haystack.size());
+}
+BENCHMARK(BM_StringPiece_Find)->RangeMultiplier(8)->Range(16, 1 << 20);
+
+static void BM_StringPiece_Find_Std(benchmark::State& state) {
+  const std::string haystack = RandomText(state.range(0)) + "needle_xyz";
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(haystack.find("needle_xyz"));
+  }
+  SetBytes(state, haystack.size());
+}
+BENCHMARK(BM_StringPiece_Find_Std)->RangeMultiplier(8)->Range(16, 1 << 20);
+
+// The pathological case for a first-and-last-byte filter: both bytes
+// recur everywhere, so nearly every position is a candidate and only the
+// last one matches.
+static void BM_StringPiece_FindRepetitive(benchmark::State& state) {
+  const std::string needle = std::string(31, 'a') + "b";
+  const std::string haystack = std::string(state.range(0), 'a') + "ab";
+  const StringPiece sp(haystack);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(sp.find(needle));
+  }
+  SetBytes(state, haystack.size());
+}
+BENCHMARK(BM_StringPiece_FindRepetitive)->RangeMultiplier(8)->Range(64, 1 << 20);
+
+static void BM_StringPiece_FindRepetitive_Std(benchmark::State& state) {
+  const std::string needle = std::string(31, 'a') + "b";
+  const std::string haystack = std::string(state.range(0), 'a') + "ab";
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(haystack.find(needle));
+  }
+  SetBytes(state, haystack.size());
+}
+BENCHMARK(BM_StringPiece_FindRepetitive_Std)->RangeMultiplier(8)->Range(64, 1 << 20);
+
+// The byte only occurs at the front, so the whole piece is scanned.
+static void BM_StringPiece_RFindChar(benchmark::State& state) {
+  const std::string text = "/" + RandomText(state.range(0));
+  const StringPiece sp(text);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(sp.rfind('/'));
+  }
+  SetBytes(state, text.size());
+}
+BENCHMARK(BM_StringPiece_RFindChar)->RangeMultiplier(8)->Range(16, 1 << 20);
+
+static void BM_StringPiece_RFindChar_Std(benchmark::State& state) {
+  const std::string text = "/" + RandomText(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(text.rfind('/'));
+  }
+  SetBytes(state, text.size());
+}
+BENCHMARK(BM_StringPiece_RFindChar_Std)->RangeMultiplier(8)->Range(16, 1 << 20);
+
+static void BM_StringPiece_FindFirstOf(benchmark::State& state) {
+  static const CharSet kDelimiters(";|\t\n");
+  const std::string text = RandomText(state.range(0)) + ";";
+  const StringPiece sp(text);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(sp.find_first_of(kDelimiters));
+  }
+  SetBytes(state, text.size());
+}
+BENCHMARK(BM_StringPiece_FindFirstOf)->RangeMultiplier(8)->Range(16, 1 << 20);
+
+static void BM_StringPiece_FindFirstOf_Std(benchmark::State& state) {
+  const std::string text = RandomText(state.range(0)) + ";";
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(text.find_first_of(";|\t\n"));
+  }
+  SetBytes(state, text.size());
+}
+BENCHMARK(BM_StringPiece_FindFirstOf_Std)->RangeMultiplier(8)->Range(16, 1 << 20);
+
+// ----------------------------------------------------------------------
+// ASCII
+// ----------------------------------------------------------------------
+
+static void BM_AsciiStrToLower(benchmark::State& state) {
+  std::string text = RandomText(state.range(0));
+  AsciiStrToUpper(&text);
+  for (auto _ : state) {
+    std::string copy = text;
+    AsciiStrToLower(&copy);
+    benchmark::DoNotOptimize(copy);
+  }
+  SetBytes(state, text.size());
+}
+BENCHMARK(BM_AsciiStrToLower)->RangeMultiplier(8)->Range(16, 1 << 20);
+
+static void BM_AsciiStrToLower_Std(benchmark::State& state) {
+  std::string text = RandomText(state.range(0));
+  AsciiStrToUpper(&text);
+  for (auto _ : state) {
+    std::string copy = text;
+    std::transform(copy.begin(), copy.end(), copy.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    benchmark::DoNotOptimize(copy);
+  }
+  SetBytes(state, text.size());
+}
+BENCHMARK(BM_AsciiStrToLower_Std)->RangeMultiplier(8)->Range(16, 1 << 20);
+
+// ----------------------------------------------------------------------
+// Numbers
+// ----------------------------------------------------------------------
+
+static void BM_FastInt64ToBuffer(benchmark::State& state) {
+  std::vector<int64_t> values(1024);
+  std::mt19937_64 rng(1);
+  for (size_t i = 0; i < values.size(); ++i) values[i] = static_cast<int64_t>(rng() >> (rng() % 63));
+  char buffer[32];
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(FastInt64ToBufferLeft(values[i++ & 1023], buffer));
+  }
+}
+BENCHMARK(BM_FastInt64ToBuffer);
+
+static void BM_FastInt64ToBuffer_Snprintf(benchmark::State& state) {
+  std::vector<int64_t> values(1024);
+  std::mt19937_64 rng(1);
+  for (size_t i = 0; i < values.size(); ++i) values[i] = static_cast<int64_t>(rng() >> (rng() % 63));
+  char buffer[32];
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(snprintf(buffer, sizeof(buffer), "%lld",
+                                      static_cast<long long>(values[i++ & 1023])));
+  }
+}
+BENCHMARK(BM_FastInt64ToBuffer_Snprintf);
+
+// Log-line timestamps: a new microsecond value on every call, and a new
+// second every 1000 calls.
+static void BM_FastIso8601TimeToBuffer(benchmark::State& state) {
+  char buffer[kFastToBufferSize];
+  int64_t micros = 1760000000LL * 1000000;
+  for (auto _ : state) {
+    micros += 1000;
+    benchmark::DoNotOptimize(FastIso8601TimeToBuffer(
+        static_cast<time_t>(micros / 1000000),
+        static_cast<int32_t>(micros % 1000000), buffer));
+  }
+}
+BENCHMARK(BM_FastIso8601TimeToBuffer);
+
+static void BM_FastIso8601TimeToBuffer_Strftime(benchmark::State& state) {
+  char buffer[kFastToBufferSize];
+  int64_t micros = 1760000000LL * 1000000;
+  for (auto _ : state) {
+    micros += 1000;
+    const time_t t = static_cast<time_t>(micros / 1000000);
+    struct tm tm;
+    gmtime_r(&t, &tm);
+    const size_t n = strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%S", &tm);
+    snprintf(buffer + n, sizeof(buffer) - n, ".%06dZ",
+             static_cast<int>(micros % 1000000));
+    benchmark::DoNotOptimize(buffer);
+  }
+}
+BENCHMARK(BM_FastIso8601TimeToBuffer_Strftime);
+
+static std::vector<std::string> DoubleStrings() {
+  std::vector<std::string> out(1024);
+  std::mt19937_64 rng(7);
+  std::uniform_real_distribution<double> dist(-1e6, 1e6);
+  for (size_t i = 0; i < out.size(); ++i) {
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%.17g", dist(rng));
+    out[i] = buffer;
+  }
+  return out;
+}
+
+static void BM_ParseDouble(benchmark::State& state) {
+  const std::vector<std::string> inputs = DoubleStrings();
+  size_t i = 0;
+  double value;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(ParseDoublePrefix(inputs[i++ & 1023], &value));
+  }
+}
+BENCHMARK(BM_ParseDouble);
+
+static void BM_ParseDouble_Strtod(benchmark::State& state) {
+  const std::vector<std::string> inputs = DoubleStrings();
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(strtod(inputs[i++ & 1023].c_str(), NULL));
+  }
+}
+BENCHMARK(BM_ParseDouble_Strtod);
+
+// ----------------------------------------------------------------------
+// Hashing: throughput by size, plus a quality counter (collisions among
+// one million short sequential keys) reported alongside.
+// ----------------------------------------------------------------------
+
+static void BM_Hash64(benchmark::State& state) {
+  const std::string data = RandomText(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Hash64(data.data(), data.size()));
+  }
+  SetBytes(state, data.size());
+}
+BENCHMARK(BM_Hash64)->RangeMultiplier(4)->Range(4, 1 << 16);
+
+static void BM_Hash64_Std(benchmark::State& state) {
+  const std::string data = RandomText(state.range(0));
+  std::hash<std::string> hasher;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(hasher(data));
+  }
+  SetBytes(state, data.size());
+}
+BENCHMARK(BM_Hash64_Std)->RangeMultiplier(4)->Range(4, 1 << 16);
+
+template <typename Hasher>
+static void HashQuality(benchmark::State& state, Hasher hasher) {
+  const int kKeys = 1 << 20;
+  for (auto _ : state) {
+    // Collisions in the low 32 bits, which is what a bucket index sees.
+    std::unordered_set<uint32_t> seen;
+    seen.reserve(kKeys);
+    for (int i = 0; i < kKeys; ++i) {
+      seen.insert(static_cast<uint32_t>(hasher("key" + std::to_string(i))));
+    }
+    // Expected for a random function: k^2 / 2^33, about 128.
+    state.counters["collisions32"] = static_cast<double>(kKeys - seen.size());
+  }
+}
+
+static void BM_Hash64_Quality(benchmark::State& state) {
+  HashQuality(state, [](const std::string& s) { return Hash64(s.data(), s.size()); });
+}
+BENCHMARK(BM_Hash64_Quality)->Iterations(1)->Unit(benchmark::kMillisecond);
+
+static void BM_Hash64_Quality_Std(benchmark::State& state) {
+  HashQuality(state, std::hash<std::string>());
+}
+BENCHMARK(BM_Hash64_Quality_Std)->Iterations(1)->Unit(benchmark::kMillisecond);
+
+// ----------------------------------------------------------------------
+// UTF-8: validation and transcoding of mostly-ASCII text with some 2-,
+// 3- and 4-byte characters, against std::wstring_convert.
+// ----------------------------------------------------------------------
+
+static std::string MixedUtf8(size_t n) {
+  static const char* const kPieces[] = {
+      "The quick brown fox ", "jumps over ", "caf\xC3\xA9 ", "\xE2\x82\xAC" "5 ",
+      "\xE6\x97\xA5\xE6\x9C\xAC ", "\xF0\x9F\x98\x80 ", "lazy dogs. ",
+  };
+  std::mt19937 rng(1);
+  std::string s;
+  while (s.size() < n) s += kPieces[rng() % 7];
+  // Cut at a character boundary.
+  size_t end = n;
+  while (end > 0 && (static_cast<unsigned char>(s[end]) & 0xC0) == 0x80) --end;
+  s.resize(end);
+  return s;
+}
+
+static void BM_IsValidUtf8(benchmark::State& state) {
+  const std::string text = MixedUtf8(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(IsValidUtf8(text));
+  }
+  SetBytes(state, text.size());
+}
+BENCHMARK(BM_IsValidUtf8)->RangeMultiplier(16)->Range(64, 1 << 20);
+
+static void BM_IsValidUtf8_Std(benchmark::State& state) {
+  const std::string text = MixedUtf8(state.range(0));
+  std::wstring_convert<std::codecvt_utf8<char32_t>, char32_t> convert;
+  for (auto _ : state) {
+    bool valid = true;
+    try {
+      benchmark::DoNotOptimize(convert.from_bytes(text));
+    } catch (const std::range_error&) {
+      valid = false;
+    }
+    benchmark::DoNotOptimize(valid);
+  }
+  SetBytes(state, text.size());
+}
+BENCHMARK(BM_IsValidUtf8_Std)->RangeMultiplier(16)->Range(64, 1 << 20);
+
+static void BM_CountUtf8CodePoints(benchmark::State& state) {
+  const std::string text = MixedUtf8(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(CountUtf8CodePoints(text));
+  }
+  SetBytes(state, text.size());
+}
+BENCHMARK(BM_CountUtf8CodePoints)->Arg(1 << 16);
+
+static void BM_Utf8ToUtf16(benchmark::State& state) {
+  const std::string text = MixedUtf8(state.range(0));
+  std::vector<char16_t> out(text.size());
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Utf8ToUtf16(text, out.data()));
+  }
+  SetBytes(state, text.size());
+}
+BENCHMARK(BM_Utf8ToUtf16)->Arg(1 << 16);
+
+static void BM_Utf8ToUtf16_Std(benchmark::State& state) {
+  const std::string text = MixedUtf8(state.range(0));
+  std::wstring_convert<std::codecvt_utf8_utf16<char16_t>, char16_t> convert;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(convert.from_bytes(text));
+  }
+  SetBytes(state, text.size());
+}
+BENCHMARK(BM_Utf8ToUtf16_Std)->Arg(1 << 16);
+
+static void BM_Utf16ToUtf8(benchmark::State& state) {
+  const std::string text = MixedUtf8(state.range(0));
+  std::vector<char16_t> wide(text.size());
+  wide.resize(Utf8ToUtf16(text, wide.data()).written);
+  std::vector<char> out(3 * wide.size());
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Utf16ToUtf8(wide.data(), wide.size(), out.data()));
+  }
+  SetBytes(state, text.size());
+}
+BENCHMARK(BM_Utf16ToUtf8)->Arg(1 << 16);
+
+// ----------------------------------------------------------------------
+// Hex and base64 over random binary blobs.  The baselines are the usual
+// byte-at-a-time loops building a std::string.
+// ----------------------------------------------------------------------
+
+static std::string RandomBytes(size_t n) {
+  std::mt19937 rng(1);
+  std::string s(n, '\0');
+  for (size_t i = 0; i < n; ++i) s[i] = static_cast<char>(rng());
+  return s;
+}
+
+static void BM_HexEncode(benchmark::State& state) {
+  const std::string data = RandomBytes(state.range(0));
+  std::vector<char> out(HexEncodedSize(data.size()));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(HexEncode(data, out.data()));
+  }
+  SetBytes(state, data.size());
+}
+BENCHMARK(BM_HexEncode)->RangeMultiplier(32)->Range(32, 1 << 20);
+
+static void BM_HexEncode_Std(benchmark::State& state) {
+  const std::string data = RandomBytes(state.range(0));
+  for (auto _ : state) {
+    std::string out;
+    out.reserve(2 * data.size());
+    char digits[3];
+    for (size_t i = 0; i < data.size(); ++i) {
+      snprintf(digits, sizeof(digits), "%02x",
+               static_cast<unsigned char>(data[i]));
+      out.append(digits, 2);
+    }
+    benchmark::DoNotOptimize(out);
+  }
+  SetBytes(state, data.size());
+}
+BENCHMARK(BM_HexEncode_Std)->RangeMultiplier(32)->Range(32, 1 << 20);
+
+static void BM_HexDecode(benchmark::State& state) {
+  const std::string data = RandomBytes(state.range(0));
+  std::vector<char> hex(HexEncodedSize(data.size()));
+  const StringPiece encoded = HexEncode(data, hex.data());
+  std::vector<char> out(data.size());
+  StringPiece decoded;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(HexDecode(encoded, out.data(), &decoded));
+  }
+  SetBytes(state, data.size());
+}
+BENCHMARK(BM_HexDecode)->RangeMultiplier(32)->Range(32, 1 << 20);
+
+static void BM_Base64Encode(benchmark::State& state) {
+  const std::string data = RandomBytes(state.range(0));
+  std::vector<char> out(Base64EncodedSize(data.size()));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Base64Encode(data, out.data()));
+  }
+  SetBytes(state, data.size());
+}
+BENCHMARK(BM_Base64Encode)->RangeMultiplier(32)->Range(32, 1 << 20);
+
+static void BM_Base64Encode_Std(benchmark::State& state) {
+  static const char kChars[] =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  const std::string data = RandomBytes(state.range(0));
+  for (auto _ : state) {
+    std::string out;
+    out.reserve(Base64EncodedSize(data.size()));
+    uint32_t bits = 0;
+    int count = 0;
+    for (size_t i = 0; i < data.size(); ++i) {
+      bits = (bits << 8) | static_cast<unsigned char>(data[i]);
+      count += 8;
+      while (count >= 6) {
+        count -= 6;
+        out.push_back(kChars[(bits >> count) & 0x3F]);
+      }
+    }
+    if (count > 0) out.push_back(kChars[(bits << (6 - count)) & 0x3F]);
+    while (out.size() % 4 != 0) out.push_back('=');
+    benchmark::DoNotOptimize(out);
+  }
+  SetBytes(state, data.size());
+}
+BENCHMARK(BM_Base64Encode_Std)->RangeMultiplier(32)->Range(32, 1 << 20);
+
+static void BM_Base64Decode(benchmark::State& state) {
+  const std::string data = RandomBytes(state.range(0));
+  std::vector<char> text(Base64EncodedSize(data.size()));
+  const StringPiece encoded = Base64Encode(data, text.data());
+  std::vector<char> out(Base64DecodedMaxSize(encoded.size()));
+  StringPiece decoded;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Base64Decode(encoded, out.data(), &decoded));
+  }
+  SetBytes(state, data.size());
+}
+BENCHMARK(BM_Base64Decode)->RangeMultiplier(32)->Range(32, 1 << 20);
+
+// ----------------------------------------------------------------------
+// C and JSON escaping
+// ----------------------------------------------------------------------
+
+// Log-message-like text.  Arg 0 has nothing to escape; arg 1 has a
+// quote, newline or tab about every 40 bytes.
+static std::string EscapeText(size_t n, bool dirty) {
+  static const char kSpecial[] = "\"\n\t\\";
+  std::mt19937 rng(42);
+  std::string s(n, ' ');
+  for (size_t i = 0; i < n; ++i) {
+    if (dirty && rng() % 40 == 0) {
+      s[i] = kSpecial[rng() % 4];
+    } else if (rng() % 6 != 0) {
+      s[i] = static_cast<char>('a' + rng() % 26);
+    }
+  }
+  return s;
+}
+
+static void BM_JsonEscapeAndAppend(benchmark::State& state) {
+  const std::string text = EscapeText(4096, state.range(0) != 0);
+  std::string out;
+  for (auto _ : state) {
+    out.clear();
+    JsonEscapeAndAppend(text, &out);
+    benchmark::DoNotOptimize(out);
+  }
+  SetBytes(state, text.size());
+}
+BENCHMARK(BM_JsonEscapeAndAppend)->Arg(0)->Arg(1);
+
+static void BM_JsonEscapeAndAppend_Std(benchmark::State& state) {
+  const std::string text = EscapeText(4096, state.range(0) != 0);
+  std::string out;
+  for (auto _ : state) {
+    out.clear();
+    for (char c : text) {
+      switch (c) {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\t': out += "\\t"; break;
+        default:
+          if (static_cast<unsigned char>(c) < 0x20) {
+            char buf[8];
+            snprintf(buf, sizeof(buf), "\\u%04x", c);
+            out += buf;
+          } else {
+            out += c;
+          }
+      }
+    }
+    benchmark::DoNotOptimize(out);
+  }
+  SetBytes(state, text.size());
+}
+BENCHMARK(BM_JsonEscapeAndAppend_Std)->Arg(0)->Arg(1);
+
+static void BM_JsonUnescapeAndAppend(benchmark::State& state) {
+  const std::string text =
+      JsonEscape(EscapeText(4096, state.range(0) != 0));
+  std::string out;
+  for (auto _ : state) {
+    out.clear();
+    benchmark::DoNotOptimize(JsonUnescapeAndAppend(text, &out));
+  }
+  SetBytes(state, text.size());
+}
+BENCHMARK(BM_JsonUnescapeAndAppend)->Arg(0)->Arg(1);
+
+static void BM_CEscapeAndAppend(benchmark::State& state) {
+  const std::string text = EscapeText(4096, state.range(0) != 0);
+  std::string out;
+  for (auto _ : state) {
+    out.clear();
+    CEscapeAndAppend(text, &out);
+    benchmark::DoNotOptimize(out);
+  }
+  SetBytes(state, text.size());
+}
+BENCHMARK(BM_CEscapeAndAppend)->Arg(0)->Arg(1);
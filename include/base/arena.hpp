@@ -0,0 +1,114 @@
+#ifndef FOUNDATION_BASE_ARENA_HPP__
+#define FOUNDATION_BASE_ARENA_HPP__
+
+#include <foundation/base/macros.hpp>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cstddef>
+
+namespace foundation {
+
+// A bump allocator.  Memory is carved sequentially out of a chain of
+// fixed-size blocks and is never freed individually; Reset() releases
+// everything at once by rewinding to the first block, keeping the blocks
+// for reuse, so a request's worth of scratch allocations costs no
+// per-object malloc/free.  Allocations larger than a quarter of the block
+// size get a dedicated block, which Reset() does free.
+//
+// Objects placed in an arena do not have their destructors run; use it
+// for trivially destructible data such as characters.
+//
+// An Arena is not thread-safe.  Use one per thread or per request.
+//
+//   Arena arena;
+//   char* buffer = arena.AllocateChars(n);
+//   ...
+//   arena.Reset();  // buffer is now invalid.
+//
+class Arena {
+ public:
+  static const size_t kDefaultBlockSize = 8192;
+
+  explicit Arena(size_t block_size = kDefaultBlockSize);
+  ~Arena();
+
+  // Returns bytes of uninitialized memory aligned to alignment, which
+  // must be a power of two.
+  void* Allocate(size_t bytes,
+                 size_t alignment = alignof(std::max_align_t)) {
+    const uintptr_t aligned =
+        (reinterpret_cast<uintptr_t>(ptr_) + alignment - 1) & ~(alignment - 1);
+    if (ptr_ != NULL && aligned + bytes <= reinterpret_cast<uintptr_t>(limit_)) {
+      ptr_ = reinterpret_cast<char*>(aligned + bytes);
+      return reinterpret_cast<void*>(aligned);
+    }
+    return AllocateSlow(bytes, alignment);
+  }
+
+  // Unaligned allocation, for character data.
+  char* AllocateChars(size_t bytes) {
+    if (bytes <= static_cast<size_t>(limit_ - ptr_)) {
+      char* result = ptr_;
+      ptr_ += bytes;
+      return result;
+    }
+    return static_cast<char*>(AllocateSlow(bytes, 1));
+  }
+
+  // If end is the end of the most recent allocation and the current block
+  // has room, grows that allocation in place by bytes and returns true.
+  bool TryExtend(const char* end, size_t bytes) {
+    if (end != ptr_ || bytes > static_cast<size_t>(limit_ - ptr_)) {
+      return false;
+    }
+    ptr_ += bytes;
+    return true;
+  }
+
+  // If end is the end of the most recent allocation, hands its last bytes
+  // back to the arena.
+  void Rewind(const char* end, size_t bytes) {
+    if (end == ptr_) ptr_ -= bytes;
+  }
+
+  // Invalidates every allocation.  Keeps the chained blocks for reuse and
+  // frees the dedicated large ones.
+  void Reset();
+
+  // Bytes handed out since construction or the last Reset(), including
+  // alignment padding but not the unused tail of each block.
+  size_t bytes_used() const;
+
+  // Bytes currently obtained from the system for blocks.
+  size_t bytes_reserved() const;
+
+ private:
+  // Over-aligned so that the data following the header is suitably
+  // aligned for anything.
+  struct alignas(alignof(std::max_align_t)) Block {
+    Block* next;
+    size_t size;
+    char* data() { return reinterpret_cast<char*>(this + 1); }
+  };
+
+  void* AllocateSlow(size_t bytes, size_t alignment);
+  static Block* NewBlock(size_t size);
+  static void FreeChain(Block* block);
+
+  const size_t block_size_;
+  Block* head_;     // Chain of block_size_ blocks.
+  Block* current_;  // Block ptr_ points into.
+  Block* large_;    // Dedicated blocks, freed by Reset().
+  size_t used_in_previous_blocks_;
+  size_t used_in_large_blocks_;
+  char* ptr_;
+  char* limit_;
+
+  DISALLOW_COPY_AND_ASSIGN(Arena);
+};
+
+}  // namespace foundation
+
+#endif  // FOUNDATION_BASE_ARENA_HPP__
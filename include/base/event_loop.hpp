@@ -0,0 +1,124 @@
+#ifndef FOUNDATION_BASE_EVENT_LOOP_HPP__
+#define FOUNDATION_BASE_EVENT_LOOP_HPP__
+
+#include <foundation/base/macros.hpp>
+#include <foundation/datetime/timer.hpp>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace foundation {
+
+// A single-threaded Linux event loop: file descriptor readiness and the
+// timer queue (AddTimer(), TimerWait, sleep_for()) served by one thread
+// that sleeps in epoll_wait() until there is something to do.
+//
+//   EventLoop loop;
+//   loop.Add(fd, EventLoop::kReadable, [&](int fd, uint32_t events) {
+//     while (read(fd, buf, sizeof(buf)) > 0) { ... }  // Drain: see below.
+//   });
+//   AddTimer(5.0f, TimerType::ONE_SHOT, [&] { loop.Stop(); });
+//   loop.Run();
+//
+// Descriptors are edge-triggered: a handler runs when the descriptor
+// becomes ready, not while it stays ready, so it must read or write until
+// EAGAIN or it will not hear about that descriptor again.
+//
+// Timers run on the loop thread.  A single timerfd is armed to the
+// earliest pending deadline, and rearmed when a timer scheduled from any
+// thread becomes the new earliest.  Other threads reach the loop through
+// Post() and Stop(), which wake it with an eventfd.
+//
+// Add(), Modify() and Remove() must be called on the loop thread, or
+// before Run(); from elsewhere, Post() them.  Every loop serves the same
+// process-wide timer queue, so run timers from one loop only unless it
+// does not matter which thread they fire on.
+//
+// Failing system calls throw std::system_error.
+class EventLoop {
+ public:
+  // Interest and readiness bits, for Add(), Modify() and handlers.
+  static const uint32_t kReadable = 1 << 0;
+  static const uint32_t kWritable = 1 << 1;
+  // Reported only: the peer hung up, or the descriptor is in error.
+  static const uint32_t kHangup = 1 << 2;
+  static const uint32_t kError = 1 << 3;
+
+  typedef std::function<void(int fd, uint32_t events)> Handler;
+
+  EventLoop();
+  ~EventLoop();
+
+  // Watches fd for events and calls handler on the loop thread when it
+  // becomes ready.  fd must not already be watched and must stay open
+  // until Remove().
+  void Add(int fd, uint32_t events, Handler handler);
+  void Modify(int fd, uint32_t events);
+  // Stops watching fd.  Safe from inside any handler, including fd's.
+  void Remove(int fd);
+
+  // Runs until Stop().  A Stop() that arrives before Run() makes it
+  // return at once.
+  void Run();
+
+  // Waits for and handles one round of events.  timeout_ms < 0 waits
+  // indefinitely; 0 just polls.  Returns the number of descriptor events
+  // handled.
+  int RunOnce(int timeout_ms = -1);
+
+  // Thread-safe.
+  void Stop();
+  // Thread-safe.  Runs fn on the loop thread, in order, after the
+  // current round's events.
+  void Post(std::function<void()> fn);
+
+ private:
+  struct Registration {
+    int fd;
+    Handler handler;
+    bool removed;
+  };
+
+  static void TimersEarlier(TimerObserver* observer);
+  void Wake();
+  void ArmTimer();
+  void RunPosted();
+
+  int epoll_fd_;
+  int timer_fd_;
+  int wake_fd_;
+
+  std::unordered_map<int, std::unique_ptr<Registration> > registrations_;
+  // Removed this round.  An event for one may still be in the batch being
+  // dispatched, so they are freed once the round is over.
+  std::vector<std::unique_ptr<Registration> > retired_;
+
+  // The deadline timer_fd_ is armed for, or max() when disarmed.
+  TimerClock::time_point armed_;
+
+  std::mutex posted_mutex_;
+  std::vector<std::function<void()> > posted_;
+
+  std::atomic<bool> stop_;
+  std::atomic<bool> wake_pending_;  // A write to wake_fd_ is unconsumed.
+
+  struct Observer : TimerObserver {
+    explicit Observer(EventLoop* loop)
+        : TimerObserver(&EventLoop::TimersEarlier), loop(loop) {}
+    EventLoop* loop;
+  };
+  Observer observer_;
+
+  DISALLOW_COPY_AND_ASSIGN(EventLoop);
+};
+
+}  // namespace foundation
+
+#endif  // FOUNDATION_BASE_EVENT_LOOP_HPP__
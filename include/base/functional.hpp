@@ -1,22 +1,90 @@
 #ifndef __FUNCTIONAL_HPP__
 #define __FUNCTIONAL_HPP__
 
+#include <foundation/base/thread_pool.hpp>
+
+#include <stddef.h>
+
 #include <algorithm>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace foundation {
 
+// Execution policies for map() and filter().
+//
+//   map( execution::seq, fn, xs );                  // same as map( fn, xs )
+//   map( execution::par, fn, xs );                  // ThreadPool::Default()
+//   execution::parallel_policy p; p.pool = &pool; p.grain = 1 << 16;
+//   filter( p, pred, std::move( xs ) );
+//
+// fn must be safe to call concurrently under par.  Results are in input
+// order either way.
+namespace execution {
+
+struct sequenced_policy {};
+
+struct parallel_policy {
+    ThreadPool* pool = nullptr;  // nullptr: ThreadPool::Default().
+    size_t grain = 0;            // Elements per chunk; 0 picks one.
+};
+
+static constexpr sequenced_policy seq {};
+static constexpr parallel_policy par {};
+
+}
+
+namespace internal {
+
+inline ThreadPool* PoolFor( execution::parallel_policy const & policy ) {
+    return policy.pool != nullptr ? policy.pool : ThreadPool::Default();
+}
+
+// A few chunks per thread so that uneven work still balances, but not so
+// many that scheduling dominates.  Rounded to a multiple of 64 so that no
+// two chunks write the same word of a std::vector<bool>.
+inline size_t GrainFor( execution::parallel_policy const & policy, ThreadPool* pool, size_t n ) {
+    size_t grain = policy.grain;
+    if ( grain == 0 ) {
+        grain = std::max<size_t>( 4096, n / ( 4 * ( pool->size() + 1 ) ) );
+    }
+    return ( grain + 63 ) & ~size_t( 63 );
+}
+
+// Output slots can be filled in parallel only if they can be created up
+// front and assigned afterwards.
+template <typename T >
+struct AssignableInPlace
+    : std::integral_constant<bool,
+          std::is_default_constructible<T>::value &&
+          std::is_move_assignable<T>::value> {};
+
+}
+
 template <typename T, typename Function >
 auto map( Function&& fn, std::vector<T > const & xs ) -> std::vector<decltype(fn(std::declval<T>()))> {
     using ReturnType = decltype(fn(std::declval<T>()));
     std::vector<ReturnType> out;
-    //out.resize( xs.size() );
+    out.reserve( xs.size() );
     for ( auto&& x : xs ) {
         out.push_back( fn( x ) );
     }
     return out;
 }
 
+// Consumes xs, handing each element to fn as an rvalue.
+template <typename T, typename Function >
+auto map( Function&& fn, std::vector<T >&& xs ) -> std::vector<decltype(fn(std::declval<T>()))> {
+    using ReturnType = decltype(fn(std::declval<T>()));
+    std::vector<ReturnType> out;
+    out.reserve( xs.size() );
+    for ( auto& x : xs ) {
+        out.push_back( fn( std::move( x ) ) );
+    }
+    return out;
+}
+
 template <typename T, typename Function >
 T filter( Function&& fn, T const & xs ) {
     T out;
@@ -28,6 +96,149 @@ T filter( Function&& fn, T const & xs ) {
     return out;
 }
 
+// Consumes xs, compacting the kept elements in place: no copies and no
+// new allocation.
+template <typename T, typename Function >
+std::vector<T > filter( Function&& fn, std::vector<T >&& xs ) {
+    xs.erase( std::remove_if( xs.begin(), xs.end(), [&fn]( T& x ) { return !fn( x ); } ), xs.end() );
+    return std::move( xs );
+}
+
+// Sequenced policy: the plain versions.
+template <typename Container, typename Function >
+auto map( execution::sequenced_policy, Function&& fn, Container&& xs )
+    -> decltype(map( std::forward<Function>( fn ), std::forward<Container>( xs ) )) {
+    return map( std::forward<Function>( fn ), std::forward<Container>( xs ) );
+}
+
+template <typename Container, typename Function >
+auto filter( execution::sequenced_policy, Function&& fn, Container&& xs )
+    -> decltype(filter( std::forward<Function>( fn ), std::forward<Container>( xs ) )) {
+    return filter( std::forward<Function>( fn ), std::forward<Container>( xs ) );
+}
+
+namespace internal {
+
+template <typename Out, typename In, typename Function >
+std::vector<Out > ParallelMap( execution::parallel_policy const & policy, Function& fn, In& xs, std::true_type ) {
+    typedef typename std::conditional<std::is_const<In>::value,
+        typename In::value_type const &, typename In::value_type&& >::type Element;
+    std::vector<Out > out( xs.size() );
+    ThreadPool* pool = PoolFor( policy );
+    pool->ParallelFor( 0, xs.size(), GrainFor( policy, pool, xs.size() ),
+        [&]( size_t begin, size_t end ) {
+            for ( size_t i = begin; i < end; ++i ) {
+                out[i] = fn( static_cast<Element>( xs[i] ) );
+            }
+        } );
+    return out;
+}
+
+// Results that cannot be assigned into place are produced serially.
+template <typename Out, typename In, typename Function >
+std::vector<Out > ParallelMap( execution::parallel_policy const &, Function& fn, In& xs, std::false_type ) {
+    typedef typename std::conditional<std::is_const<In>::value,
+        typename In::value_type const &, typename In::value_type&& >::type Element;
+    std::vector<Out > out;
+    out.reserve( xs.size() );
+    for ( auto& x : xs ) {
+        out.push_back( fn( static_cast<Element>( x ) ) );
+    }
+    return out;
+}
+
+// Step 3 of ParallelFilter: every chunk writes its own slice of out.
+template <typename Element, typename In, typename T >
+void ScatterKept( ThreadPool* pool, size_t grain, In& xs, std::vector<unsigned char > const & keep,
+                  std::vector<size_t > const & offsets, std::vector<T >* out, std::true_type ) {
+    out->resize( offsets.back() );
+    pool->ParallelFor( 0, xs.size(), grain, [&]( size_t begin, size_t end ) {
+        size_t o = offsets[begin / grain];
+        for ( size_t i = begin; i < end; ++i ) {
+            if ( keep[i] ) {
+                ( *out )[o++] = static_cast<Element>( xs[i] );
+            }
+        }
+    } );
+}
+
+template <typename Element, typename In, typename T >
+void ScatterKept( ThreadPool*, size_t, In& xs, std::vector<unsigned char > const & keep,
+                  std::vector<size_t > const & offsets, std::vector<T >* out, std::false_type ) {
+    out->reserve( offsets.back() );
+    for ( size_t i = 0; i < xs.size(); ++i ) {
+        if ( keep[i] ) {
+            out->push_back( static_cast<Element>( xs[i] ) );
+        }
+    }
+}
+
+// Stable parallel filter as a blocked prefix sum:
+//   1. each chunk evaluates the predicate, remembering the verdicts, and
+//      counts its survivors;
+//   2. an exclusive scan of the per-chunk counts gives each chunk its
+//      output offset (there are only a few chunks per thread, so this
+//      pass is serial);
+//   3. each chunk copies, or moves, its survivors to its offset.
+template <typename In, typename Function >
+std::vector<typename In::value_type > ParallelFilter( execution::parallel_policy const & policy, Function& fn, In& xs ) {
+    typedef typename In::value_type T;
+    typedef typename std::conditional<std::is_const<In>::value, T const &, T&& >::type Element;
+    const size_t n = xs.size();
+    ThreadPool* pool = PoolFor( policy );
+    const size_t grain = GrainFor( policy, pool, n );
+    const size_t chunks = ( n + grain - 1 ) / grain;
+
+    std::vector<unsigned char > keep( n );
+    std::vector<size_t > offsets( chunks + 1, 0 );
+    pool->ParallelFor( 0, n, grain, [&]( size_t begin, size_t end ) {
+        size_t count = 0;
+        for ( size_t i = begin; i < end; ++i ) {
+            keep[i] = fn( xs[i] ) ? 1 : 0;
+            count += keep[i];
+        }
+        offsets[begin / grain + 1] = count;
+    } );
+    for ( size_t c = 0; c < chunks; ++c ) {
+        offsets[c + 1] += offsets[c];
+    }
+
+    // std::vector<bool> packs neighbours into one word, so its elements
+    // cannot be written from different threads.
+    typedef std::integral_constant<bool,
+        AssignableInPlace<T >::value && !std::is_same<T, bool>::value> InPlace;
+    std::vector<T > out;
+    ScatterKept<Element >( pool, grain, xs, keep, offsets, &out, InPlace() );
+    return out;
+}
+
+}
+
+// Parallel policy: chunks of xs run on a ThreadPool.  The output is
+// allocated once at its final size and each chunk writes its own slice.
+template <typename T, typename Function >
+auto map( execution::parallel_policy const & policy, Function&& fn, std::vector<T > const & xs )
+    -> std::vector<decltype(fn(std::declval<T>()))> {
+    using ReturnType = decltype(fn(std::declval<T>()));
+    return internal::ParallelMap<ReturnType >( policy, fn, xs, internal::AssignableInPlace<ReturnType >() );
+}
+
+template <typename T, typename Function >
+auto map( execution::parallel_policy const & policy, Function&& fn, std::vector<T >&& xs )
+    -> std::vector<decltype(fn(std::declval<T>()))> {
+    using ReturnType = decltype(fn(std::declval<T>()));
+    return internal::ParallelMap<ReturnType >( policy, fn, xs, internal::AssignableInPlace<ReturnType >() );
+}
+
+template <typename T, typename Function >
+std::vector<T > filter( execution::parallel_policy const & policy, Function&& fn, std::vector<T > const & xs ) {
+    return internal::ParallelFilter( policy, fn, xs );
+}
+
+template <typename T, typename Function >
+std::vector<T > filter( execution::parallel_policy const & policy, Function&& fn, std::vector<T >&& xs ) {
+    return internal::ParallelFilter( policy, fn, xs );
+}
 
 }
 
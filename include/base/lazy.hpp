@@ -0,0 +1,427 @@
+#ifndef FOUNDATION_BASE_LAZY_HPP__
+#define FOUNDATION_BASE_LAZY_HPP__
+
+#include <stddef.h>
+
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace foundation {
+
+// ----------------------------------------------------------------------
+// Lazy range adaptors
+//    Where filter(f, map(g, xs)) builds a whole vector per stage, a
+//    pipeline of adaptors is a lightweight description of the stages that
+//    runs them element by element, in one pass, only when the result is
+//    consumed:
+//
+//      std::vector<int> ids =
+//          (records | lazy::filter(IsActive) | lazy::map(IdOf)
+//                   | lazy::take(100)).collect();
+//
+//      for (int n : StrSplit(line, ',') | lazy::map(ParseField)) { ... }
+//
+//    The source is any range with begin()/end(): std::vector, StrSplit()
+//    or split() output, another pipeline.  An lvalue source is referenced
+//    and must outlive the pipeline; an rvalue source is moved into it.
+//
+//    Consuming a pipeline:
+//      - range-for / begin() and end(), one element at a time;
+//      - for_each(fn), which drives the stages from the source loop so
+//        that the compiler sees a single loop with the stages inlined
+//        into its body, and stops early after take();
+//      - collect() into a std::vector, or to<Container>(); both use
+//        for_each() and reserve up front when the size is known.
+//
+//    Functions are applied on every access: dereferencing the same map
+//    iterator twice calls the function twice.
+// ----------------------------------------------------------------------
+
+namespace lazy {
+
+namespace internal {
+
+template <typename Range>
+struct RangeTraits {
+  typedef decltype(std::begin(std::declval<Range&>())) iterator;
+  typedef decltype(*std::declval<iterator&>()) reference;
+  typedef typename std::decay<reference>::type value_type;
+};
+
+// Size of a sized range, or -1.
+template <typename Range>
+auto SizeOf(const Range& range, int) -> decltype(ptrdiff_t(range.size())) {
+  return static_cast<ptrdiff_t>(range.size());
+}
+
+template <typename Range>
+ptrdiff_t SizeOf(const Range&, long) {
+  return -1;
+}
+
+}  // namespace internal
+
+// CRTP base supplying the terminal operations.
+template <typename Derived>
+class View {
+ public:
+  // Calls fn(element) for each element, in order.
+  template <typename Function>
+  void for_each(Function fn) {
+    self().Drive([&fn](auto&& x) {
+      fn(std::forward<decltype(x)>(x));
+      return true;
+    });
+  }
+
+  template <typename Container>
+  Container to() {
+    Container out;
+    Reserve(&out, 0);
+    self().Drive([&out](auto&& x) {
+      out.insert(out.end(), std::forward<decltype(x)>(x));
+      return true;
+    });
+    return out;
+  }
+
+  template <typename Self = Derived>
+  std::vector<typename Self::value_type> collect() {
+    return to<std::vector<typename Self::value_type> >();
+  }
+
+ private:
+  Derived& self() { return static_cast<Derived&>(*this); }
+
+  template <typename Container>
+  auto Reserve(Container* out, int) -> decltype(out->reserve(0), void()) {
+    const ptrdiff_t n = self().size_hint();
+    if (n > 0) out->reserve(static_cast<size_t>(n));
+  }
+
+  template <typename Container>
+  void Reserve(Container*, long) {}
+};
+
+// The source stage: refers to, or owns, the underlying range.
+template <typename Range>
+class Source : public View<Source<Range> > {
+  typedef typename std::remove_reference<Range>::type Stored;
+
+ public:
+  typedef typename internal::RangeTraits<Stored>::iterator iterator;
+  typedef iterator const_iterator;
+  typedef typename internal::RangeTraits<Stored>::value_type value_type;
+
+  explicit Source(Range&& range) : range_(std::forward<Range>(range)) {}
+
+  iterator begin() { return std::begin(range_); }
+  iterator end() { return std::end(range_); }
+
+  ptrdiff_t size_hint() const { return internal::SizeOf(range_, 0); }
+
+  // Feeds elements to sink until it returns false.  Returns false if it
+  // stopped early.
+  template <typename Sink>
+  bool Drive(Sink&& sink) {
+    for (auto it = std::begin(range_), end = std::end(range_); it != end;
+         ++it) {
+      if (!sink(*it)) return false;
+    }
+    return true;
+  }
+
+ private:
+  // Range is T& for an lvalue source and T for an rvalue one.
+  Range range_;
+};
+
+template <typename Base, typename Function>
+class MapView : public View<MapView<Base, Function> > {
+  typedef typename Base::iterator BaseIterator;
+
+ public:
+  typedef decltype(std::declval<Function&>()(*std::declval<BaseIterator&>()))
+      reference;
+  typedef typename std::decay<reference>::type value_type;
+
+  class iterator {
+   public:
+    typedef std::input_iterator_tag iterator_category;
+    typedef typename MapView::value_type value_type;
+    typedef ptrdiff_t difference_type;
+    typedef const value_type* pointer;
+    typedef typename MapView::reference reference;
+
+    iterator() : fn_(NULL) {}
+    iterator(BaseIterator it, Function* fn) : it_(it), fn_(fn) {}
+
+    reference operator*() const { return (*fn_)(*it_); }
+    iterator& operator++() {
+      ++it_;
+      return *this;
+    }
+    iterator operator++(int) {
+      iterator old = *this;
+      ++it_;
+      return old;
+    }
+    bool operator==(const iterator& other) const { return it_ == other.it_; }
+    bool operator!=(const iterator& other) const { return it_ != other.it_; }
+
+   private:
+    BaseIterator it_;
+    Function* fn_;
+  };
+  typedef iterator const_iterator;
+
+  MapView(Base base, Function fn) : base_(std::move(base)), fn_(std::move(fn)) {}
+
+  iterator begin() { return iterator(base_.begin(), &fn_); }
+  iterator end() { return iterator(base_.end(), &fn_); }
+
+  ptrdiff_t size_hint() const { return base_.size_hint(); }
+
+  template <typename Sink>
+  bool Drive(Sink&& sink) {
+    Function& fn = fn_;
+    return base_.Drive([&sink, &fn](auto&& x) {
+      return sink(fn(std::forward<decltype(x)>(x)));
+    });
+  }
+
+ private:
+  Base base_;
+  Function fn_;
+};
+
+template <typename Base, typename Predicate>
+class FilterView : public View<FilterView<Base, Predicate> > {
+  typedef typename Base::iterator BaseIterator;
+
+ public:
+  typedef typename Base::value_type value_type;
+
+  class iterator {
+   public:
+    typedef std::input_iterator_tag iterator_category;
+    typedef typename FilterView::value_type value_type;
+    typedef ptrdiff_t difference_type;
+    typedef typename std::iterator_traits<BaseIterator>::pointer pointer;
+    typedef decltype(*std::declval<BaseIterator&>()) reference;
+
+    iterator() : pred_(NULL) {}
+    iterator(BaseIterator it, BaseIterator end, Predicate* pred)
+        : it_(it), end_(end), pred_(pred) {
+      Skip();
+    }
+
+    reference operator*() const { return *it_; }
+    iterator& operator++() {
+      ++it_;
+      Skip();
+      return *this;
+    }
+    iterator operator++(int) {
+      iterator old = *this;
+      ++*this;
+      return old;
+    }
+    bool operator==(const iterator& other) const { return it_ == other.it_; }
+    bool operator!=(const iterator& other) const { return it_ != other.it_; }
+
+   private:
+    void Skip() {
+      while (it_ != end_ && !(*pred_)(*it_)) ++it_;
+    }
+
+    BaseIterator it_;
+    BaseIterator end_;
+    Predicate* pred_;
+  };
+  typedef iterator const_iterator;
+
+  FilterView(Base base, Predicate pred)
+      : base_(std::move(base)), pred_(std::move(pred)) {}
+
+  iterator begin() { return iterator(base_.begin(), base_.end(), &pred_); }
+  iterator end() { return iterator(base_.end(), base_.end(), &pred_); }
+
+  // Unknown until run.
+  ptrdiff_t size_hint() const { return -1; }
+
+  template <typename Sink>
+  bool Drive(Sink&& sink) {
+    Predicate& pred = pred_;
+    return base_.Drive([&sink, &pred](auto&& x) {
+      return pred(x) ? sink(std::forward<decltype(x)>(x)) : true;
+    });
+  }
+
+ private:
+  Base base_;
+  Predicate pred_;
+};
+
+template <typename Base>
+class TakeView : public View<TakeView<Base> > {
+  typedef typename Base::iterator BaseIterator;
+
+ public:
+  typedef typename Base::value_type value_type;
+
+  class iterator {
+   public:
+    typedef std::input_iterator_tag iterator_category;
+    typedef typename TakeView::value_type value_type;
+    typedef ptrdiff_t difference_type;
+    typedef typename std::iterator_traits<BaseIterator>::pointer pointer;
+    typedef decltype(*std::declval<BaseIterator&>()) reference;
+
+    iterator() : left_(0) {}
+    iterator(BaseIterator it, BaseIterator end, size_t left)
+        : it_(it), end_(end), left_(it == end ? 0 : left) {}
+
+    reference operator*() const { return *it_; }
+    // Does not advance the base past the last element taken, so a
+    // filter below is not asked to search beyond it.
+    iterator& operator++() {
+      if (--left_ != 0) {
+        ++it_;
+        if (it_ == end_) left_ = 0;
+      }
+      return *this;
+    }
+    iterator operator++(int) {
+      iterator old = *this;
+      ++*this;
+      return old;
+    }
+    // All exhausted iterators are equal.
+    bool operator==(const iterator& other) const {
+      return left_ == other.left_ && (left_ == 0 || it_ == other.it_);
+    }
+    bool operator!=(const iterator& other) const { return !(*this == other); }
+
+   private:
+    BaseIterator it_;
+    BaseIterator end_;
+    size_t left_;
+  };
+  typedef iterator const_iterator;
+
+  TakeView(Base base, size_t n) : base_(std::move(base)), n_(n) {}
+
+  iterator begin() { return iterator(base_.begin(), base_.end(), n_); }
+  iterator end() { return iterator(base_.end(), base_.end(), 0); }
+
+  ptrdiff_t size_hint() const {
+    const ptrdiff_t base = base_.size_hint();
+    const ptrdiff_t n = static_cast<ptrdiff_t>(n_);
+    return base < 0 ? -1 : (base < n ? base : n);
+  }
+
+  template <typename Sink>
+  bool Drive(Sink&& sink) {
+    if (n_ == 0) return true;
+    size_t left = n_;
+    bool stopped = false;
+    base_.Drive([&sink, &left, &stopped](auto&& x) {
+      if (!sink(std::forward<decltype(x)>(x))) {
+        stopped = true;
+        return false;
+      }
+      return --left != 0;
+    });
+    // Meeting the quota ends the source loop but is not an early stop as
+    // far as the stages downstream are concerned.
+    return !stopped;
+  }
+
+ private:
+  Base base_;
+  size_t n_;
+};
+
+// Adaptor objects, applied with operator|.
+template <typename Function>
+struct MapAdaptor {
+  Function fn;
+};
+
+template <typename Predicate>
+struct FilterAdaptor {
+  Predicate pred;
+};
+
+struct TakeAdaptor {
+  size_t n;
+};
+
+template <typename Function>
+MapAdaptor<typename std::decay<Function>::type> map(Function&& fn) {
+  return MapAdaptor<typename std::decay<Function>::type>{
+      std::forward<Function>(fn)};
+}
+
+template <typename Predicate>
+FilterAdaptor<typename std::decay<Predicate>::type> filter(Predicate&& pred) {
+  return FilterAdaptor<typename std::decay<Predicate>::type>{
+      std::forward<Predicate>(pred)};
+}
+
+inline TakeAdaptor take(size_t n) {
+  return TakeAdaptor{n};
+}
+
+namespace internal {
+
+template <typename T>
+struct IsView : std::is_base_of<View<typename std::decay<T>::type>,
+                                typename std::decay<T>::type> {};
+
+// A pipeline stage stays a stage; any other range becomes a Source.
+template <typename Range, bool = IsView<Range>::value>
+struct AsView {
+  typedef Source<Range> type;
+  static type Make(Range&& range) { return type(std::forward<Range>(range)); }
+};
+
+template <typename Range>
+struct AsView<Range, true> {
+  typedef typename std::decay<Range>::type type;
+  static type Make(Range&& range) { return type(std::forward<Range>(range)); }
+};
+
+}  // namespace internal
+
+template <typename Range, typename Function>
+MapView<typename internal::AsView<Range>::type, Function>
+operator|(Range&& range, MapAdaptor<Function> adaptor) {
+  return MapView<typename internal::AsView<Range>::type, Function>(
+      internal::AsView<Range>::Make(std::forward<Range>(range)),
+      std::move(adaptor.fn));
+}
+
+template <typename Range, typename Predicate>
+FilterView<typename internal::AsView<Range>::type, Predicate>
+operator|(Range&& range, FilterAdaptor<Predicate> adaptor) {
+  return FilterView<typename internal::AsView<Range>::type, Predicate>(
+      internal::AsView<Range>::Make(std::forward<Range>(range)),
+      std::move(adaptor.pred));
+}
+
+template <typename Range>
+TakeView<typename internal::AsView<Range>::type>
+operator|(Range&& range, TakeAdaptor adaptor) {
+  return TakeView<typename internal::AsView<Range>::type>(
+      internal::AsView<Range>::Make(std::forward<Range>(range)), adaptor.n);
+}
+
+}  // namespace lazy
+
+}  // namespace foundation
+
+#endif  // FOUNDATION_BASE_LAZY_HPP__
@@ -0,0 +1,264 @@
+#ifndef FOUNDATION_BASE_METRICS_HPP__
+#define FOUNDATION_BASE_METRICS_HPP__
+
+#include <foundation/base/macros.hpp>
+#include <foundation/strings/stringpiece.hpp>
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// In-process metrics: counters, gauges and histograms, exported in the
+// Prometheus text exposition format.
+//
+//   static metrics::Counter* requests =
+//       metrics::Registry::Default()->GetCounter("http_requests_total",
+//                                                "Requests served.");
+//   static metrics::Histogram* latency =
+//       metrics::Registry::Default()->GetHistogram("http_latency_us",
+//                                                  "Handler latency.");
+//   requests->Increment();
+//   latency->Observe(elapsed_us);
+//
+//   std::string body;
+//   metrics::Registry::Default()->WritePrometheusText(&body);
+//
+// Looking a metric up by name takes the registry lock, so do it once and
+// keep the pointer, which stays valid for the life of the registry.
+// Updating through the pointer never locks: counters and histograms are
+// split into kShards cache-line-sized cells and each thread writes only
+// its own cell, so concurrent updates do not contend.  The cells are
+// summed when the registry is scraped.
+
+namespace foundation {
+namespace metrics {
+
+static const int kShards = 8;
+
+namespace internal {
+
+// The cell this thread updates, in [0, kShards).  Threads are dealt
+// cells round-robin as they first touch a metric.
+int AssignShard();
+
+inline int ThisThreadShard() {
+  static thread_local int shard = AssignShard();
+  return shard;
+}
+
+struct alignas(64) PaddedCounter {
+  std::atomic<uint64_t> value;
+};
+
+// C++14 new ignores alignment beyond max_align_t, so metrics holding
+// cache-line-aligned cells allocate through this instead.
+struct CacheLineAligned {
+  static void* operator new(size_t size);
+  static void operator delete(void* p);
+};
+
+}  // namespace internal
+
+// ----------------------------------------------------------------------
+// Counter
+//    A monotonically increasing count.
+// ----------------------------------------------------------------------
+class Counter : public internal::CacheLineAligned {
+ public:
+  Counter();
+
+  void Increment(uint64_t n = 1) {
+    // Only this thread's shard is written, but other threads may share
+    // it, so the add must still be atomic.
+    cells_[internal::ThisThreadShard()].value.fetch_add(
+        n, std::memory_order_relaxed);
+  }
+
+  uint64_t Value() const;
+
+ private:
+  internal::PaddedCounter cells_[kShards];
+
+  DISALLOW_COPY_AND_ASSIGN(Counter);
+};
+
+// ----------------------------------------------------------------------
+// Gauge
+//    A value that can go up and down.  Set() is a single store; Add() is
+//    a compare-and-swap loop, so a gauge adjusted from many threads at
+//    once is better kept as a pair of counters.
+// ----------------------------------------------------------------------
+class Gauge {
+ public:
+  Gauge() : bits_(0) {}
+
+  void Set(double value) {
+    bits_.store(ToBits(value), std::memory_order_relaxed);
+  }
+  void Add(double delta) {
+    uint64_t old = bits_.load(std::memory_order_relaxed);
+    while (!bits_.compare_exchange_weak(old, ToBits(FromBits(old) + delta),
+                                        std::memory_order_relaxed)) {
+    }
+  }
+  void Increment() { Add(1); }
+  void Decrement() { Add(-1); }
+
+  double Value() const {
+    return FromBits(bits_.load(std::memory_order_relaxed));
+  }
+
+ private:
+  static uint64_t ToBits(double d) {
+    uint64_t u;
+    memcpy(&u, &d, sizeof(u));
+    return u;
+  }
+  static double FromBits(uint64_t u) {
+    double d;
+    memcpy(&d, &u, sizeof(d));
+    return d;
+  }
+
+  std::atomic<uint64_t> bits_;
+
+  DISALLOW_COPY_AND_ASSIGN(Gauge);
+};
+
+// ----------------------------------------------------------------------
+// Histogram
+//    The distribution of non-negative integer observations, such as
+//    latencies in microseconds.
+//
+//    Buckets are log-linear: each power of two is split into
+//    kSubBuckets equal parts, so a value is placed in a bucket at most
+//    1/kSubBuckets wider than the value itself, at any magnitude, with no
+//    configuration.  Values below kSubBuckets get a bucket each.  Finding
+//    the bucket is a count-leading-zeros and a shift.
+//
+//    Each of the kShards cells holds every bucket (about 2 KB), so
+//    histograms are cheap to update but not tiny; prefer a handful per
+//    component to one per key.
+// ----------------------------------------------------------------------
+class Histogram : public internal::CacheLineAligned {
+ public:
+  static const int kSubBucketBits = 2;
+  static const int kSubBuckets = 1 << kSubBucketBits;
+  static const int kBuckets = (64 - kSubBucketBits + 1) * kSubBuckets;
+
+  struct Snapshot {
+    uint64_t count;
+    uint64_t sum;
+    std::vector<uint64_t> buckets;  // kBuckets counts, not cumulative.
+  };
+
+  Histogram();
+
+  void Observe(uint64_t value) {
+    Cell& cell = cells_[internal::ThisThreadShard()];
+    cell.buckets[BucketFor(value)].fetch_add(1, std::memory_order_relaxed);
+    cell.sum.fetch_add(value, std::memory_order_relaxed);
+  }
+
+  // Sums the cells.  Updates racing with the snapshot may be missed, but
+  // count always equals the sum of the buckets.
+  Snapshot GetSnapshot() const;
+
+  static int BucketFor(uint64_t value) {
+    if (value < static_cast<uint64_t>(kSubBuckets)) {
+      return static_cast<int>(value);
+    }
+    const int shift = 63 - __builtin_clzll(value) - kSubBucketBits;
+    return (shift + 1) * kSubBuckets +
+           static_cast<int>((value >> shift) - kSubBuckets);
+  }
+
+  // The largest value that lands in bucket.
+  static uint64_t BucketUpperBound(int bucket) {
+    if (bucket < kSubBuckets) {
+      return static_cast<uint64_t>(bucket);
+    }
+    const int shift = bucket / kSubBuckets - 1;
+    const uint64_t mantissa = bucket % kSubBuckets + kSubBuckets;
+    return ((mantissa + 1) << shift) - 1;
+  }
+
+ private:
+  struct alignas(64) Cell {
+    std::atomic<uint64_t> sum;
+    std::atomic<uint64_t> buckets[kBuckets];
+  };
+
+  Cell cells_[kShards];
+
+  DISALLOW_COPY_AND_ASSIGN(Histogram);
+};
+
+// ----------------------------------------------------------------------
+// Registry
+//    Owns metrics by name and renders them for scraping.  Safe to use
+//    from any number of threads.
+//
+//    Names must match [a-zA-Z_:][a-zA-Z0-9_:]*.  labels, if given, is a
+//    preformatted Prometheus label list without the braces, such as
+//      method="GET",code="200"
+//    Metrics with the same name and different labels form one family and
+//    share the help text of the first registration.  Asking for an
+//    existing name and labels returns the existing metric.  Asking for a
+//    name already registered as a different type, or passing an invalid
+//    name, throws std::invalid_argument.
+// ----------------------------------------------------------------------
+class Registry {
+ public:
+  Registry();
+  ~Registry();
+
+  // The process-wide registry.  Never destroyed, so metric pointers stay
+  // valid during static destruction.
+  static Registry* Default();
+
+  Counter* GetCounter(StringPiece name, StringPiece help,
+                      StringPiece labels = StringPiece());
+  Gauge* GetGauge(StringPiece name, StringPiece help,
+                  StringPiece labels = StringPiece());
+  Histogram* GetHistogram(StringPiece name, StringPiece help,
+                          StringPiece labels = StringPiece());
+
+  // Appends every metric in the Prometheus text format (version 0.0.4),
+  // families sorted by name.  Histograms list the cumulative buckets from
+  // the lowest to the highest non-empty one; since counts only grow, a
+  // bucket that has appeared in one scrape appears in every later one.
+  void WritePrometheusText(std::string* out) const;
+
+ private:
+  enum Type { kCounter, kGauge, kHistogram };
+
+  struct Entry {
+    std::string name;
+    std::string labels;
+    std::string help;
+    Type type;
+    std::unique_ptr<Counter> counter;
+    std::unique_ptr<Gauge> gauge;
+    std::unique_ptr<Histogram> histogram;
+  };
+
+  Entry* FindOrAdd(StringPiece name, StringPiece help, StringPiece labels,
+                   Type type);
+
+  mutable std::mutex mutex_;
+  std::vector<std::unique_ptr<Entry> > entries_;
+
+  DISALLOW_COPY_AND_ASSIGN(Registry);
+};
+
+}  // namespace metrics
+}  // namespace foundation
+
+#endif  // FOUNDATION_BASE_METRICS_HPP__
@@ -0,0 +1,197 @@
+#ifndef FOUNDATION_BASE_THREAD_POOL_HPP__
+#define FOUNDATION_BASE_THREAD_POOL_HPP__
+
+#include <foundation/base/macros.hpp>
+#include <foundation/base/work_stealing_deque.hpp>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace foundation {
+
+// A work-stealing pool of worker threads.
+//
+//   ThreadPool* pool = ThreadPool::Default();
+//   std::future<int> f = pool->Submit([] { return 42; });
+//   pool->ParallelFor(0, n, 4096, [&](size_t begin, size_t end) { ... });
+//
+// Each worker owns a Chase-Lev deque.  Tasks scheduled from a worker go
+// on its own deque and run LIFO, while they are still hot in cache; idle
+// workers steal the oldest tasks from others.  Tasks scheduled from
+// outside the pool go on a shared injection queue.  So a task that fans
+// out into many small tasks never touches a lock, and a pool that is
+// busy never touches the sleeping workers' condition variable.
+//
+// There is no ordering between tasks.  The destructor runs every task
+// already queued, including ones they schedule, then joins the workers.
+class ThreadPool {
+ public:
+  struct Options {
+    Options() : threads(0), pin_threads(false) {}
+
+    size_t threads;  // 0: one per hardware thread.
+
+    // Pins worker i to cpus[i % cpus.size()] if cpus is not empty,
+    // otherwise to CPU i if pin_threads is set.  Linux only; ignored
+    // elsewhere.
+    bool pin_threads;
+    std::vector<int> cpus;
+  };
+
+  // threads == 0 means one per hardware thread.
+  explicit ThreadPool(size_t threads = 0);
+  explicit ThreadPool(const Options& options);
+  ~ThreadPool();
+
+  size_t size() const { return workers_.size(); }
+
+  // Queues fn to run on a worker.  Exceptions thrown by fn are swallowed;
+  // use Submit() to observe them.
+  void Schedule(std::function<void()> fn);
+
+  // Queues fn and returns a future for its result (or exception).
+  template <typename Function>
+  std::future<decltype(std::declval<Function&>()())> Submit(Function fn);
+
+  // Runs body(chunk_begin, chunk_end) over [begin, end) split into chunks
+  // of about grain elements, on the workers and the calling thread, and
+  // returns when all chunks are done.  Chunks are claimed dynamically, so
+  // uneven work balances itself.  Safe to call from inside a task: the
+  // caller never waits on a chunk nobody is running.  The first exception
+  // thrown by body is rethrown here once the remaining chunks finish.
+  template <typename Body>
+  void ParallelFor(size_t begin, size_t end, size_t grain, Body&& body);
+
+  // The index of the calling worker in this pool, or -1 if the caller is
+  // not one of its workers.
+  int CurrentWorker() const;
+
+  // A process-wide pool with one worker per hardware thread.
+  static ThreadPool* Default();
+
+ private:
+  typedef std::function<void()> Task;
+  struct Worker;
+
+  void Start(const Options& options);
+  void WorkerLoop(size_t index);
+  Task* FindTask(size_t index, uint64_t* rng);
+  Task* StealTask(size_t index, uint64_t* rng);
+  void WakeOne();
+
+  std::vector<std::unique_ptr<Worker> > workers_;
+
+  // Injection queue for tasks scheduled from outside the pool.
+  std::mutex injection_mutex_;
+  std::deque<Task*> injection_;
+  std::atomic<size_t> injected_;  // injection_.size(), readable unlocked.
+
+  // Parking.  Workers that find nothing to do bump sleepers_ and wait for
+  // wake_epoch_ to change; schedulers only take sleep_mutex_ when
+  // sleepers_ is non-zero.
+  std::mutex sleep_mutex_;
+  std::condition_variable wake_;
+  std::atomic<int> sleepers_;
+  uint64_t wake_epoch_;  // Guarded by sleep_mutex_.
+  std::atomic<bool> stopping_;
+
+  DISALLOW_COPY_AND_ASSIGN(ThreadPool);
+};
+
+template <typename Function>
+std::future<decltype(std::declval<Function&>()())>
+ThreadPool::Submit(Function fn) {
+  typedef decltype(std::declval<Function&>()()) Result;
+  // std::function needs a copyable target, so the task goes behind a
+  // shared_ptr.
+  std::shared_ptr<std::packaged_task<Result()> > task =
+      std::make_shared<std::packaged_task<Result()> >(std::move(fn));
+  std::future<Result> future = task->get_future();
+  Schedule([task] { (*task)(); });
+  return future;
+}
+
+namespace internal {
+
+// Shared between the caller of ParallelFor and its helper tasks, which
+// may start after the loop has finished and so must not touch the stack.
+struct ParallelForState {
+  ParallelForState(size_t begin, size_t end, size_t grain)
+      : begin(begin), end(end), grain(grain), next(begin), done(0) {}
+
+  const size_t begin, end, grain;
+  std::atomic<size_t> next;  // First unclaimed index.
+  std::atomic<size_t> done;  // Elements finished.
+  std::mutex mutex;
+  std::condition_variable finished;
+  std::exception_ptr error;
+};
+
+}  // namespace internal
+
+template <typename Body>
+void ThreadPool::ParallelFor(size_t begin, size_t end, size_t grain,
+                             Body&& body) {
+  if (begin >= end) return;
+  if (grain == 0) grain = 1;
+  const size_t chunks = (end - begin + grain - 1) / grain;
+  if (chunks == 1 || workers_.empty()) {
+    body(begin, end);
+    return;
+  }
+
+  typedef internal::ParallelForState State;
+  std::shared_ptr<State> state = std::make_shared<State>(begin, end, grain);
+  typename std::remove_reference<Body>::type* fn = &body;
+
+  // Claims and runs chunks until none are left.  Helpers only dereference
+  // fn after claiming a chunk, and the caller cannot return while a
+  // claimed chunk is unfinished, so fn is still alive when they do.
+  auto run = [state, fn]() {
+    for (;;) {
+      const size_t b = state->next.fetch_add(state->grain);
+      if (b >= state->end) return;
+      const size_t e = std::min(b + state->grain, state->end);
+      try {
+        (*fn)(b, e);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if (!state->error) state->error = std::current_exception();
+      }
+      if (state->done.fetch_add(e - b) + (e - b) == state->end - state->begin) {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->finished.notify_all();
+      }
+    }
+  };
+
+  const size_t helpers = std::min(chunks - 1, workers_.size());
+  for (size_t i = 0; i < helpers; ++i) {
+    Schedule(run);
+  }
+  run();
+
+  std::unique_lock<std::mutex> lock(state->mutex);
+  state->finished.wait(lock, [&] {
+    return state->done.load() == state->end - state->begin;
+  });
+  if (state->error) std::rethrow_exception(state->error);
+}
+
+}  // namespace foundation
+
+#endif  // FOUNDATION_BASE_THREAD_POOL_HPP__
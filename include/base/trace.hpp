@@ -0,0 +1,118 @@
+#ifndef FOUNDATION_BASE_TRACE_HPP__
+#define FOUNDATION_BASE_TRACE_HPP__
+
+// Lightweight in-process tracing, viewable in chrome://tracing or
+// https://ui.perfetto.dev.
+//
+//   void Handle() {
+//     TRACE_SCOPE("net", "Handle");      // A span covering this scope.
+//     ...
+//     TRACE_INSTANT("net", "cache-miss");  // A point in time.
+//   }
+//
+//   foundation::trace::Start();
+//   ...
+//   foundation::trace::Stop();
+//   foundation::trace::WriteChromeJson(&file);
+//
+// Events go to a ring buffer owned by the recording thread: recording is
+// a timestamp read (RDTSC on x86) and a few stores, with no lock and no
+// shared cache line.  Each ring keeps the most recent kEventsPerThread
+// events.  Categories and names must be string literals, or otherwise
+// outlive the trace, since only the pointers are stored.
+//
+// Tracing is compiled in only when FOUNDATION_TRACING is 1 (the CMake
+// option FOUNDATION_ENABLE_TRACING).  Otherwise the macros expand to
+// nothing and the functions below do nothing.  When compiled in but not
+// started, a trace point costs one relaxed load.
+
+#ifndef FOUNDATION_TRACING
+#define FOUNDATION_TRACING 0
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <string>
+
+namespace foundation {
+namespace trace {
+
+static const size_t kEventsPerThread = 1 << 14;
+
+// Starts recording.  Events recorded before a previous Stop() are kept
+// until Clear().
+void Start();
+void Stop();
+void Clear();
+
+// Appends the recorded events as a Chrome trace-event JSON document.
+// Safe to call while other threads are recording; events overwritten
+// during the export are left out.
+void WriteChromeJson(std::string* out);
+
+#if FOUNDATION_TRACING
+
+namespace internal {
+
+extern std::atomic<bool> g_enabled;
+
+inline bool Enabled() {
+  return g_enabled.load(std::memory_order_relaxed);
+}
+
+uint64_t Now();
+void RecordSpan(const char* category, const char* name, uint64_t begin,
+                uint64_t end);
+void RecordInstant(const char* category, const char* name);
+
+}  // namespace internal
+
+// Records a complete ("X") event from construction to destruction.
+class Span {
+ public:
+  Span(const char* category, const char* name)
+      : category_(category), name_(name),
+        begin_(internal::Enabled() ? internal::Now() : 0) {}
+
+  ~Span() {
+    if (begin_ != 0) {
+      internal::RecordSpan(category_, name_, begin_, internal::Now());
+    }
+  }
+
+ private:
+  const char* category_;
+  const char* name_;
+  uint64_t begin_;
+
+  Span(const Span&) = delete;
+  void operator=(const Span&) = delete;
+};
+
+#define FOUNDATION_TRACE_CONCAT_(a, b) a##b
+#define FOUNDATION_TRACE_CONCAT(a, b) FOUNDATION_TRACE_CONCAT_(a, b)
+
+#define TRACE_SCOPE(category, name)                               \
+  ::foundation::trace::Span FOUNDATION_TRACE_CONCAT(trace_span_, \
+                                                    __LINE__)(category, name)
+
+#define TRACE_INSTANT(category, name)                              \
+  do {                                                             \
+    if (::foundation::trace::internal::Enabled()) {                \
+      ::foundation::trace::internal::RecordInstant(category, name); \
+    }                                                              \
+  } while (0)
+
+#else  // !FOUNDATION_TRACING
+
+#define TRACE_SCOPE(category, name) ((void)0)
+#define TRACE_INSTANT(category, name) ((void)0)
+
+#endif  // FOUNDATION_TRACING
+
+}  // namespace trace
+}  // namespace foundation
+
+#endif  // FOUNDATION_BASE_TRACE_HPP__
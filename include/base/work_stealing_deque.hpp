@@ -0,0 +1,136 @@
+#ifndef FOUNDATION_BASE_WORK_STEALING_DEQUE_HPP__
+#define FOUNDATION_BASE_WORK_STEALING_DEQUE_HPP__
+
+#include <foundation/base/macros.hpp>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace foundation {
+
+// A Chase-Lev work-stealing deque of pointers (Chase & Lev, "Dynamic
+// Circular Work-Stealing Deque", SPAA 2005, with the memory orderings of
+// Le et al., PPoPP 2013).
+//
+// One owner thread pushes and pops at the bottom, LIFO, touching no
+// shared cache line in the common case; any number of thieves steal from
+// the top, FIFO, with one CAS.  Only the last element is contended.
+//
+// The buffer grows when full.  Superseded buffers are kept until the
+// deque is destroyed, because a thief may still be reading one.
+template <typename T>
+class WorkStealingDeque {
+ public:
+  explicit WorkStealingDeque(size_t capacity = 256)
+      : top_(0), bottom_(0) {
+    size_t size = 1;
+    while (size < capacity) size <<= 1;
+    buffers_.emplace_back(new Buffer(size));
+    buffer_.store(buffers_.back().get(), std::memory_order_relaxed);
+  }
+
+  // Owner only.
+  void Push(T* item) {
+    const int64_t b = bottom_.load(std::memory_order_relaxed);
+    const int64_t t = top_.load(std::memory_order_acquire);
+    Buffer* buffer = buffer_.load(std::memory_order_relaxed);
+    if (b - t > static_cast<int64_t>(buffer->mask)) {
+      buffer = Grow(buffer, t, b);
+    }
+    buffer->Put(b, item);
+    bottom_.store(b + 1, std::memory_order_release);
+  }
+
+  // Owner only.  Returns NULL if the deque is empty.
+  T* Pop() {
+    const int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+    Buffer* buffer = buffer_.load(std::memory_order_relaxed);
+    // The store to bottom must be ordered before the load of top, or the
+    // owner and a thief could both take the last element.
+    bottom_.store(b, std::memory_order_seq_cst);
+    int64_t t = top_.load(std::memory_order_seq_cst);
+    if (t > b) {
+      bottom_.store(b + 1, std::memory_order_relaxed);
+      return NULL;
+    }
+    T* item = buffer->Get(b);
+    if (t == b) {
+      // Last element: race the thieves for it.
+      if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                        std::memory_order_relaxed)) {
+        item = NULL;
+      }
+      bottom_.store(b + 1, std::memory_order_relaxed);
+    }
+    return item;
+  }
+
+  // Any thread.  Returns NULL if the deque is empty or another thread
+  // won the race for the top element.
+  T* Steal() {
+    int64_t t = top_.load(std::memory_order_seq_cst);
+    const int64_t b = bottom_.load(std::memory_order_seq_cst);
+    if (t >= b) {
+      return NULL;
+    }
+    Buffer* buffer = buffer_.load(std::memory_order_acquire);
+    T* item = buffer->Get(t);
+    if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                      std::memory_order_relaxed)) {
+      return NULL;
+    }
+    return item;
+  }
+
+  // A racy hint, exact only when the deque is quiescent.
+  bool empty() const {
+    return bottom_.load(std::memory_order_seq_cst) <=
+           top_.load(std::memory_order_seq_cst);
+  }
+
+ private:
+  struct Buffer {
+    explicit Buffer(size_t size) : mask(size - 1), slots(size) {}
+
+    T* Get(int64_t i) const {
+      return slots[static_cast<size_t>(i) & mask].load(
+          std::memory_order_relaxed);
+    }
+    void Put(int64_t i, T* item) {
+      slots[static_cast<size_t>(i) & mask].store(item,
+                                                 std::memory_order_relaxed);
+    }
+
+    const size_t mask;
+    std::vector<std::atomic<T*> > slots;
+  };
+
+  Buffer* Grow(Buffer* old, int64_t top, int64_t bottom) {
+    Buffer* bigger = new Buffer((old->mask + 1) * 2);
+    for (int64_t i = top; i < bottom; ++i) {
+      bigger->Put(i, old->Get(i));
+    }
+    buffers_.emplace_back(bigger);
+    buffer_.store(bigger, std::memory_order_release);
+    return bigger;
+  }
+
+  // top_ is written by thieves and bottom_ by the owner; the padding
+  // keeps them on separate cache lines.  (Padding rather than alignas,
+  // which operator new need not honour before C++17.)
+  std::atomic<int64_t> top_;
+  char padding_[64];
+  std::atomic<int64_t> bottom_;
+  std::atomic<Buffer*> buffer_;
+  std::vector<std::unique_ptr<Buffer> > buffers_;  // Owner only.
+
+  DISALLOW_COPY_AND_ASSIGN(WorkStealingDeque);
+};
+
+}  // namespace foundation
+
+#endif  // FOUNDATION_BASE_WORK_STEALING_DEQUE_HPP__
@@ -0,0 +1,409 @@
+#ifndef FOUNDATION_DATETIME_COROUTINE_HPP__
+#define FOUNDATION_DATETIME_COROUTINE_HPP__
+
+// C++20 coroutine support on top of the timer subsystem.
+//
+//   foundation::Task<int> Fetch();
+//
+//   foundation::Task<> Poll() {
+//     for (;;) {
+//       std::optional<int> v =
+//           co_await foundation::with_timeout(Fetch(), std::chrono::seconds(1));
+//       if (!v) Log(1, "fetch timed out");
+//       co_await foundation::sleep_for(std::chrono::milliseconds(100));
+//     }
+//   }
+//
+//   Poll().Detach();
+//   for (;;) UpdateTimers();  // Sleeps resume here...
+//
+// ...or on a ThreadPool, if one is passed as the executor.  A sleep is a
+// TimerWait embedded in the awaiting coroutine's frame, so awaiting one
+// allocates nothing beyond the timer heap's slot.
+//
+// Everything here needs C++20 coroutines; in older language modes this
+// header is empty.  The library itself does not, so it can stay on C++14
+// and only code using coroutines needs -std=c++20.
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+
+#include <foundation/base/thread_pool.hpp>
+#include <foundation/datetime/timer.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace foundation {
+
+template <typename T = void>
+class Task;
+
+namespace internal {
+
+// Resumes handle on executor, or on this thread if there is none.
+inline void ResumeOn(ThreadPool* executor, std::coroutine_handle<> handle) {
+  if (executor != nullptr) {
+    executor->Schedule([handle] { handle.resume(); });
+  } else {
+    handle.resume();
+  }
+}
+
+class TaskPromiseBase {
+ public:
+  struct FinalAwaiter {
+    bool await_ready() noexcept { return false; }
+    // Hands control straight to the awaiting coroutine, so chains of
+    // tasks completing synchronously do not grow the stack.
+    template <typename Promise>
+    std::coroutine_handle<> await_suspend(
+        std::coroutine_handle<Promise> handle) noexcept {
+      TaskPromiseBase& promise = handle.promise();
+      if (promise.detached_) {
+        handle.destroy();
+        return std::noop_coroutine();
+      }
+      if (promise.continuation_) return promise.continuation_;
+      return std::noop_coroutine();
+    }
+    void await_resume() noexcept {}
+  };
+
+  std::suspend_always initial_suspend() noexcept { return {}; }
+  FinalAwaiter final_suspend() noexcept { return {}; }
+
+  // Like an exception escaping a std::thread, one escaping a detached
+  // task terminates the process.
+  void unhandled_exception() noexcept {
+    if (detached_) std::terminate();
+    exception_ = std::current_exception();
+  }
+
+ protected:
+  template <typename T>
+  friend class foundation::Task;
+
+  void RethrowIfFailed() {
+    if (exception_) std::rethrow_exception(exception_);
+  }
+
+  std::coroutine_handle<> continuation_;
+  std::exception_ptr exception_;
+  bool detached_ = false;
+};
+
+template <typename T>
+class TaskPromise : public TaskPromiseBase {
+ public:
+  Task<T> get_return_object() noexcept;
+
+  template <typename U>
+  void return_value(U&& value) {
+    value_.emplace(std::forward<U>(value));
+  }
+
+  T Result() {
+    RethrowIfFailed();
+    return std::move(*value_);
+  }
+
+ private:
+  std::optional<T> value_;
+};
+
+template <>
+class TaskPromise<void> : public TaskPromiseBase {
+ public:
+  Task<void> get_return_object() noexcept;
+
+  void return_void() noexcept {}
+
+  void Result() { RethrowIfFailed(); }
+};
+
+}  // namespace internal
+
+// ----------------------------------------------------------------------
+// Task<T>
+//    A lazily started coroutine producing a T.  Nothing runs until the
+//    task is awaited, which may happen once:
+//
+//      int v = co_await Compute();
+//
+//    or detached, which starts it and frees its frame when it finishes:
+//
+//      Run().Detach();
+//
+//    Exceptions propagate to the awaiter.  Destroying a task that was
+//    never started destroys its frame.
+// ----------------------------------------------------------------------
+template <typename T>
+class Task {
+ public:
+  typedef internal::TaskPromise<T> promise_type;
+
+  Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+  Task& operator=(Task&& other) noexcept {
+    if (this != &other) {
+      if (handle_) handle_.destroy();
+      handle_ = std::exchange(other.handle_, {});
+    }
+    return *this;
+  }
+  Task(const Task&) = delete;
+  Task& operator=(const Task&) = delete;
+
+  ~Task() {
+    if (handle_) handle_.destroy();
+  }
+
+  auto operator co_await() && noexcept {
+    struct Awaiter {
+      std::coroutine_handle<promise_type> handle;
+
+      bool await_ready() noexcept { return false; }
+      std::coroutine_handle<> await_suspend(
+          std::coroutine_handle<> awaiting) noexcept {
+        handle.promise().continuation_ = awaiting;
+        return handle;
+      }
+      T await_resume() { return handle.promise().Result(); }
+    };
+    return Awaiter{handle_};
+  }
+
+  void Detach() && {
+    std::coroutine_handle<promise_type> handle = std::exchange(handle_, {});
+    handle.promise().detached_ = true;
+    handle.resume();
+  }
+
+ private:
+  friend class internal::TaskPromise<T>;
+
+  explicit Task(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+  std::coroutine_handle<promise_type> handle_;
+};
+
+namespace internal {
+
+template <typename T>
+Task<T> TaskPromise<T>::get_return_object() noexcept {
+  return Task<T>(std::coroutine_handle<TaskPromise>::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() noexcept {
+  return Task<void>(std::coroutine_handle<TaskPromise>::from_promise(*this));
+}
+
+}  // namespace internal
+
+// ----------------------------------------------------------------------
+// sleep_for()
+// sleep_until()
+//    Suspend the awaiting coroutine until the deadline has passed and
+//    UpdateTimers() has run.  It then resumes on the thread that called
+//    UpdateTimers(), or on executor if one is given.  A deadline that
+//    has already passed does not suspend at all.
+// ----------------------------------------------------------------------
+class SleepAwaiter : private TimerWait {
+ public:
+  SleepAwaiter(TimerClock::time_point deadline, ThreadPool* executor)
+      : TimerWait(&SleepAwaiter::Fire), when_(deadline), executor_(executor) {}
+  SleepAwaiter(const SleepAwaiter&) = delete;
+  SleepAwaiter& operator=(const SleepAwaiter&) = delete;
+
+  bool await_ready() const noexcept { return when_ <= TimerClock::now(); }
+  void await_suspend(std::coroutine_handle<> handle) {
+    handle_ = handle;
+    // Once scheduled, this may be resumed, and destroyed, at any moment.
+    ScheduleTimerWait(this, when_);
+  }
+  void await_resume() const noexcept {}
+
+ private:
+  static void Fire(TimerWait* wait) {
+    SleepAwaiter* self = static_cast<SleepAwaiter*>(wait);
+    internal::ResumeOn(self->executor_, self->handle_);
+  }
+
+  TimerClock::time_point when_;
+  ThreadPool* executor_;
+  std::coroutine_handle<> handle_;
+};
+
+inline SleepAwaiter sleep_until(TimerClock::time_point deadline,
+                                ThreadPool* executor = nullptr) {
+  return SleepAwaiter(deadline, executor);
+}
+
+template <typename Rep, typename Period>
+SleepAwaiter sleep_for(std::chrono::duration<Rep, Period> duration,
+                       ThreadPool* executor = nullptr) {
+  return SleepAwaiter(
+      TimerClock::now() + std::chrono::ceil<TimerClock::duration>(duration),
+      executor);
+}
+
+namespace internal {
+
+// A coroutine that starts immediately and frees itself when done.
+struct Detached {
+  struct promise_type {
+    Detached get_return_object() noexcept { return {}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() noexcept {}
+    void unhandled_exception() noexcept { std::terminate(); }
+  };
+};
+
+// What with_timeout() produces: the task's value, or nothing on timeout.
+template <typename T>
+struct TimeoutResult {
+  typedef std::optional<T> type;
+};
+template <>
+struct TimeoutResult<void> {
+  typedef bool type;
+};
+
+// Shared by the awaiting coroutine, the task runner and the timer, each
+// holding a reference, since any of them may be the last to finish.
+template <typename T>
+class TimeoutState : public TimerWait {
+ public:
+  typedef typename TimeoutResult<T>::type Result;
+
+  enum { kRacing, kCompleted, kTimedOut };
+
+  explicit TimeoutState(ThreadPool* executor)
+      : TimerWait(&TimeoutState::Fire), executor_(executor) {}
+
+  // Starts the timer and the task.  Returns false if the race was decided
+  // before the caller had finished suspending, in which case the caller
+  // must carry on rather than wait to be resumed.
+  bool Start(std::shared_ptr<TimeoutState> self, Task<T> task,
+             TimerClock::time_point deadline, std::coroutine_handle<> waiter) {
+    waiter_ = waiter;
+    timer_ref_ = self;
+    ScheduleTimerWait(this, deadline);
+    Run(std::move(self), std::move(task));
+    return unresumed_.fetch_sub(1, std::memory_order_acq_rel) != 1;
+  }
+
+  Result TakeResult() {
+    if (exception_) std::rethrow_exception(exception_);
+    return std::move(result_);
+  }
+
+ private:
+  static Detached Run(std::shared_ptr<TimeoutState> self, Task<T> task) {
+    Result result{};
+    std::exception_ptr exception;
+    try {
+      if constexpr (std::is_void<T>::value) {
+        co_await std::move(task);
+        result = true;
+      } else {
+        result.emplace(co_await std::move(task));
+      }
+    } catch (...) {
+      exception = std::current_exception();
+    }
+    if (!self->Decide(kCompleted)) co_return;
+    // Only the winner writes, and the waiter reads after being resumed.
+    self->result_ = std::move(result);
+    self->exception_ = exception;
+    if (CancelTimerWait(self.get())) self->timer_ref_.reset();
+    self->ResumeWaiter();
+  }
+
+  static void Fire(TimerWait* wait) {
+    TimeoutState* state = static_cast<TimeoutState*>(wait);
+    std::shared_ptr<TimeoutState> self = std::move(state->timer_ref_);
+    if (self->Decide(kTimedOut)) self->ResumeWaiter();
+  }
+
+  bool Decide(int outcome) {
+    int racing = kRacing;
+    return winner_.compare_exchange_strong(racing, outcome,
+                                           std::memory_order_acq_rel);
+  }
+
+  // Resumes the waiter, unless it has not finished suspending yet, in
+  // which case Start() returns false and it simply continues.
+  void ResumeWaiter() {
+    if (unresumed_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      ResumeOn(executor_, waiter_);
+    }
+  }
+
+  ThreadPool* const executor_;
+  std::coroutine_handle<> waiter_;
+  std::shared_ptr<TimeoutState> timer_ref_;  // Held while scheduled.
+  std::atomic<int> winner_{kRacing};
+  std::atomic<int> unresumed_{2};
+  Result result_{};
+  std::exception_ptr exception_;
+};
+
+template <typename T>
+class TimeoutAwaiter {
+ public:
+  TimeoutAwaiter(Task<T> task, TimerClock::time_point deadline,
+                 ThreadPool* executor)
+      : task_(std::move(task)),
+        deadline_(deadline),
+        state_(std::make_shared<TimeoutState<T> >(executor)) {}
+
+  bool await_ready() const noexcept { return false; }
+  bool await_suspend(std::coroutine_handle<> waiter) {
+    return state_->Start(state_, std::move(task_), deadline_, waiter);
+  }
+  typename TimeoutResult<T>::type await_resume() {
+    return state_->TakeResult();
+  }
+
+ private:
+  Task<T> task_;
+  TimerClock::time_point deadline_;
+  std::shared_ptr<TimeoutState<T> > state_;
+};
+
+}  // namespace internal
+
+// ----------------------------------------------------------------------
+// with_timeout()
+//    Awaits task for at most duration.  Produces a std::optional<T>,
+//    empty on timeout (for Task<void>, a bool: true if it completed).
+//    An exception from a task that finished in time is rethrown.
+//
+//    A task that times out is not cancelled: it runs on to completion in
+//    the background and its result is discarded.  The awaiter resumes on
+//    executor if one is given; otherwise on the thread that completed the
+//    task, or on timeout the thread that called UpdateTimers().
+//    Each call allocates one shared state and one runner frame.
+// ----------------------------------------------------------------------
+template <typename T, typename Rep, typename Period>
+internal::TimeoutAwaiter<T> with_timeout(
+    Task<T> task, std::chrono::duration<Rep, Period> duration,
+    ThreadPool* executor = nullptr) {
+  return internal::TimeoutAwaiter<T>(
+      std::move(task),
+      TimerClock::now() + std::chrono::ceil<TimerClock::duration>(duration),
+      executor);
+}
+
+}  // namespace foundation
+
+#endif  // __cpp_impl_coroutine
+
+#endif  // FOUNDATION_DATETIME_COROUTINE_HPP__
@@ -3,6 +3,10 @@
 
 #include <foundation/uuid/uuid.hpp>
 
+#include <stddef.h>
+#include <stdint.h>
+
+#include <chrono>
 #include <functional>
 
 enum class TimerType
@@ -11,9 +15,65 @@ enum class TimerType
   CYCLE
 };
 
+// Calls callback once delay seconds from now, or every delay seconds for
+// CYCLE.  The handle can be passed to StopTimer(), including from inside
+// the callback.
 uuid AddTimer( float delay, TimerType flag, std::function<void () > callback );
 void StopTimer( uuid handle );
 
+// Runs the callbacks of every timer and TimerWait that is due.  Timers
+// fire on the thread that calls this.
 void UpdateTimers();
 
+typedef std::chrono::steady_clock TimerClock;
+
+// The earliest pending deadline, if any timer or TimerWait is scheduled.
+bool NextTimerDeadline( TimerClock::time_point* deadline );
+
+// A one-shot timer whose storage belongs to the caller, for waiters that
+// already own memory that outlives the wait (an awaiter in a coroutine
+// frame, say).  Scheduling one allocates nothing, and the deadline has
+// the steady clock's resolution rather than a time_t's.
+//
+// Once a TimerWait is due, UpdateTimers() unschedules it and calls
+// fire( wait ) without holding any lock, so fire may schedule the wait
+// again or release the memory it lives in.
+struct TimerWait
+{
+  static const size_t kNotScheduled = ~size_t( 0 );
+
+  explicit TimerWait( void ( *fire )( TimerWait* ) )
+    : fire( fire ),
+      heapIndex( kNotScheduled ),
+      sequence( 0 )
+  {}
+
+  void ( *fire )( TimerWait* );
+  TimerClock::time_point deadline;
+  size_t heapIndex;   //< Owned by the timer subsystem.
+  uint64_t sequence;  //< Owned by the timer subsystem.
+};
+
+void ScheduleTimerWait( TimerWait* wait, TimerClock::time_point deadline );
+
+// Returns true if the wait was unscheduled before it fired.  False means
+// it was never scheduled, or that fire has been or is being called.
+bool CancelTimerWait( TimerWait* wait );
+
+// Told whenever a newly scheduled timer becomes the earliest, so that a
+// thread sleeping until the old earliest deadline can wake up and wait
+// for the new one instead.  earlier is called with the timer lock held:
+// it must be quick and must not call back into the timer functions.
+struct TimerObserver
+{
+  explicit TimerObserver( void ( *earlier )( TimerObserver* ) )
+    : earlier( earlier )
+  {}
+
+  void ( *earlier )( TimerObserver* );
+};
+
+void AddTimerObserver( TimerObserver* observer );
+void RemoveTimerObserver( TimerObserver* observer );
+
 #endif // TIMER_HPP__
@@ -1,6 +1,8 @@
 #ifndef __COMMAND_DISPATCHER_HPP__
 #define __COMMAND_DISPATCHER_HPP__
 
+#include <foundation/base/trace.hpp>
+
 #include <assert.h>
 #include <functional>
 #include <map>
@@ -30,6 +32,7 @@ struct CommandDispatcher {
 
     template <typename ...Args>
     void process(Key const & command, Args&&... args) {
+      TRACE_SCOPE("dispatcher", "CommandDispatcher::process");
       if (exists(command)) {
         m_CommandMap[command](args...);
       }
@@ -0,0 +1,138 @@
+#ifndef FOUNDATION_ASYNC_FILE_LOGGER_HPP__
+#define FOUNDATION_ASYNC_FILE_LOGGER_HPP__
+
+#include <foundation/logger/logger.hpp>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+// A Logger that appends to a file from a background thread, so that
+// write() costs a lock and a memcpy and never waits on the disk.
+//
+//   AsyncFileLogger::Options options;
+//   options.buffer_size = 4 << 20;
+//   AsyncFileLogger sink( "/var/log/app.log", options );
+//   RegisterLogger( &sink, 0 );
+//
+// Lines are copied into the current buffer.  A full buffer is handed to
+// the writer thread, which keeps up to `buffers - 1` of them in flight at
+// once, each written at its own file offset, and recycles a buffer as
+// soon as its write completes.  Partly filled buffers are written after
+// flush_interval_ms, or on Flush().
+//
+// The writer uses io_uring where the kernel allows it: the buffers are
+// registered with the ring up front and submitted as fixed-buffer writes,
+// many per system call.  Otherwise it falls back to gathering the ready
+// buffers into one pwritev() per round.  If the ring itself starts
+// failing, the writes it holds are counted as failed (see error()) and
+// the logger switches to pwritev() for good.
+//
+// Each line lands in the file whole.  If there is not room for it,
+// write() waits for buffers to be recycled; with drop_when_full it
+// discards the line instead and counts it.  Only a line longer than all
+// the buffers together is split, and may then be interleaved with lines
+// written concurrently.
+//
+// The logger assumes it is the only writer of the file.
+class AsyncFileLogger : public Logger
+{
+public:
+  enum Backend
+  {
+    AUTO,      //< io_uring if available, otherwise pwritev.
+    IO_URING,  //< io_uring or throw.
+    PWRITEV
+  };
+
+  struct Options
+  {
+    Options()
+      : buffer_size( 1 << 20 ),
+        buffers( 8 ),
+        flush_interval_ms( 100 ),
+        drop_when_full( false ),
+        backend( AUTO )
+    {}
+
+    size_t buffer_size;
+    size_t buffers;  //< At least 2.
+    int flush_interval_ms;  //< Above 0; an idle logger wakes this often.
+    bool drop_when_full;
+    Backend backend;
+  };
+
+  // Opens path for appending, creating it if need be.  Throws
+  // std::invalid_argument for options out of range, and
+  // std::system_error if the file cannot be opened, or if IO_URING was
+  // asked for and is unavailable.
+  explicit AsyncFileLogger( std::string const& path,
+                            Options const& options = Options() );
+  // Writes everything still buffered, then closes the file.
+  ~AsyncFileLogger();
+
+  void write( std::string const& line );
+
+  // Blocks until every line written before the call has reached the
+  // kernel (not necessarily the disk).
+  void Flush();
+
+  bool using_io_uring() const;
+  uint64_t dropped() const;
+  // errno of the most recent failed write, or 0.
+  int error() const;
+
+private:
+  struct Buffer
+  {
+    char* data;
+    size_t size;      //< Bytes filled.
+    size_t written;   //< Bytes the writer has completed.
+    uint64_t offset;  //< File offset of data[0].
+    int index;        //< Position among the registered buffers.
+  };
+
+  // The I/O backends.
+  class Writer;
+  class IoUringWriter;
+  class PwritevWriter;
+
+  void Append( char const* data, size_t size );
+  bool Rotate( std::unique_lock<std::mutex>& lock );
+  void SwapCurrent();
+  void Run();
+
+  Options const options;
+  int fd;
+  std::unique_ptr<Writer> writer;
+  std::vector<Buffer> buffers;
+  char* memory;
+
+  mutable std::mutex mutex;
+  std::condition_variable readyToWrite;  //< Writer: sealed buffers, flush, stop.
+  std::condition_variable recycled;      //< Producers: a free buffer.
+  std::condition_variable flushed;       //< Flush(): completedBytes moved.
+
+  Buffer* current;
+  std::vector<Buffer*> freeBuffers;
+  std::deque<Buffer*> sealed;
+  uint64_t nextOffset;
+  uint64_t acceptedBytes;   //< Bytes handed to write() and kept.
+  uint64_t completedBytes;  //< Bytes whose write finished or failed.
+  uint64_t droppedLines;
+  int lastError;
+  bool flushRequested;
+  bool stopping;
+
+  std::thread thread;
+};
+
+#endif // FOUNDATION_ASYNC_FILE_LOGGER_HPP__
@@ -22,8 +22,20 @@ public:
 };
 
 
+// The timestamp SendToLogger() puts in front of each line, in UTC:
+//   ISO8601  "2026-10-19T08:49:37.123456Z line"  (the default)
+//   RFC822   "Mon, 19 Oct 2026 08:49:37 GMT line"
+enum class LogTimestamp
+{
+  NONE,
+  RFC822,
+  ISO8601
+};
+
 void ClearLoggers();
 void RegisterLogger( Logger* logger, int threshold );
+// Set this before logging starts; it is not synchronised with SendToLogger().
+void SetLogTimestamp( LogTimestamp format );
 void SendToLogger( int level, std::string const& line );
 
 
@@ -0,0 +1,87 @@
+
+#ifndef FOUNDATION_STRINGS_ARENA_STRCAT_H_
+#define FOUNDATION_STRINGS_ARENA_STRCAT_H_
+
+#include <foundation/base/arena.hpp>
+#include <foundation/base/macros.hpp>
+#include <foundation/strings/strcat.hpp>
+#include <foundation/strings/stringpiece.hpp>
+
+#include <stddef.h>
+
+#include <initializer_list>
+
+
+namespace foundation {
+
+// ----------------------------------------------------------------------
+// Arena-backed strings
+//    StrCat() and StrAppend() build heap-allocated strings.  The functions
+//    here write the same AlphaNum arguments into an Arena instead and hand
+//    back StringPieces into it, so short-lived strings cost a pointer bump
+//    each and are all released together by Arena::Reset().  The returned
+//    StringPieces are valid until then.
+//
+//      Arena arena;
+//      StringPiece key = ArenaStrCat(&arena, "user:", id, ":", field);
+//      StringPiece copy = ArenaCopy(&arena, token);
+// ----------------------------------------------------------------------
+
+namespace internal {
+StringPiece ArenaCatPieces(Arena* arena,
+                           std::initializer_list<StringPiece> pieces);
+}  // namespace internal
+
+// Copies s into the arena.
+StringPiece ArenaCopy(Arena* arena, StringPiece s);
+
+// Concatenates its arguments into a single arena allocation.
+template <typename... Args>
+StringPiece ArenaStrCat(Arena* arena, const Args&... args) {
+  // The AlphaNum temporaries live until the end of this full expression,
+  // so the pieces pointing at their digit buffers stay valid for the call.
+  return internal::ArenaCatPieces(arena, {AlphaNum(args).piece...});
+}
+
+// Builds one string incrementally in an arena.  While it is the most
+// recent arena allocation the string grows in place; otherwise it moves,
+// doubling its capacity.  Finish() returns the result and gives any
+// unused capacity back to the arena.
+//
+//   ArenaStringBuilder builder(&arena);
+//   for (...) builder.Append(name, "=", value, ";");
+//   StringPiece result = builder.Finish();
+//
+class ArenaStringBuilder {
+ public:
+  explicit ArenaStringBuilder(Arena* arena)
+      : arena_(arena), data_(NULL), size_(0), capacity_(0) {}
+
+  template <typename... Args>
+  ArenaStringBuilder& Append(const Args&... args) {
+    AppendPieces({AlphaNum(args).piece...});
+    return *this;
+  }
+
+  // The string built so far.  Invalidated by the next Append().
+  StringPiece piece() const { return StringPiece(data_, size_); }
+  size_t size() const { return size_; }
+
+  // Returns the finished string and starts a new, empty one.
+  StringPiece Finish();
+
+ private:
+  void AppendPieces(std::initializer_list<StringPiece> pieces);
+  void Grow(size_t needed);
+
+  Arena* arena_;
+  char* data_;
+  size_t size_;
+  size_t capacity_;
+
+  DISALLOW_COPY_AND_ASSIGN(ArenaStringBuilder);
+};
+
+}  // namespace foundation
+
+#endif  // FOUNDATION_STRINGS_ARENA_STRCAT_H_
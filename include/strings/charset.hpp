@@ -0,0 +1,103 @@
+// A CharSet is a set of byte values, precomputed once so that searches
+// for "any of these characters" do not rebuild a lookup table per call.
+//
+// CharSet can be built at compile time:
+//
+//   static constexpr CharSet kWhitespace(" \t\r\n");
+//   sp.find_first_not_of(kWhitespace);
+//
+// It holds two representations of the same set:
+//   - a 256-bit bitmap, for scalar membership tests, and
+//   - a pair of 16-entry nibble tables, for vector scans.  Byte b is in
+//     the set iff bit (b >> 4) & 7 of table[b & 15] is set, where the
+//     table is low_table() for b < 0x80 and high_table() otherwise.  This
+//     is the layout PSHUFB-based kernels need to classify 16 or 32 bytes
+//     per instruction.
+
+#ifndef FOUNDATION_STRINGS_CHARSET_H_
+#define FOUNDATION_STRINGS_CHARSET_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace foundation {
+
+class CharSet {
+ public:
+  constexpr CharSet() : bits_{}, low_table_{}, high_table_{} {}
+
+  // The set of characters in the '\0'-terminated string chars.
+  constexpr explicit CharSet(const char* chars)
+      : bits_{}, low_table_{}, high_table_{} {
+    for (; *chars != '\0'; ++chars) {
+      Add(static_cast<unsigned char>(*chars));
+    }
+  }
+
+  // The set of characters in chars[0, n); may include '\0'.
+  constexpr CharSet(const char* chars, size_t n)
+      : bits_{}, low_table_{}, high_table_{} {
+    for (size_t i = 0; i < n; ++i) {
+      Add(static_cast<unsigned char>(chars[i]));
+    }
+  }
+
+  // The characters lo..hi inclusive.
+  static constexpr CharSet Range(unsigned char lo, unsigned char hi) {
+    CharSet set;
+    for (unsigned c = lo; c <= hi; ++c) {
+      set.Add(static_cast<unsigned char>(c));
+    }
+    return set;
+  }
+
+  constexpr bool contains(unsigned char c) const {
+    return ((bits_[c >> 6] >> (c & 63)) & 1) != 0;
+  }
+
+  constexpr bool empty() const {
+    return (bits_[0] | bits_[1] | bits_[2] | bits_[3]) == 0;
+  }
+
+  constexpr CharSet operator|(const CharSet& other) const {
+    CharSet set;
+    for (int i = 0; i < 4; ++i) set.bits_[i] = bits_[i] | other.bits_[i];
+    for (int i = 0; i < 16; ++i) {
+      set.low_table_[i] = low_table_[i] | other.low_table_[i];
+      set.high_table_[i] = high_table_[i] | other.high_table_[i];
+    }
+    return set;
+  }
+
+  constexpr CharSet operator~() const {
+    CharSet set;
+    for (int i = 0; i < 4; ++i) set.bits_[i] = ~bits_[i];
+    for (int i = 0; i < 16; ++i) {
+      set.low_table_[i] = static_cast<uint8_t>(~low_table_[i]);
+      set.high_table_[i] = static_cast<uint8_t>(~high_table_[i]);
+    }
+    return set;
+  }
+
+  // Nibble tables for the vector kernels; see the comment at the top.
+  const uint8_t* low_table() const { return low_table_; }
+  const uint8_t* high_table() const { return high_table_; }
+
+ private:
+  constexpr void Add(unsigned char c) {
+    bits_[c >> 6] |= uint64_t(1) << (c & 63);
+    if (c < 0x80) {
+      low_table_[c & 15] |= static_cast<uint8_t>(1u << (c >> 4));
+    } else {
+      high_table_[c & 15] |= static_cast<uint8_t>(1u << ((c >> 4) - 8));
+    }
+  }
+
+  uint64_t bits_[4];
+  uint8_t low_table_[16];
+  uint8_t high_table_[16];
+};
+
+}  // namespace foundation
+
+#endif  // FOUNDATION_STRINGS_CHARSET_H_
@@ -0,0 +1,142 @@
+// Bulk binary-to-text encodings, hex and base64 (RFC 4648, standard and
+// URL-safe alphabets), and C and JSON string escaping.
+//
+// FastHex32ToBuffer() and friends in numbers.hpp format one integer.
+// These work on whole buffers: blobs, digests, tokens and IDs.
+//
+// The hex and base64 functions come in two forms.  One writes into a
+// caller-provided buffer, which must have room for the *EncodedSize() or
+// *DecodedMaxSize() of the input.  The other allocates exactly that from
+// an Arena.  Both return a StringPiece over the output, valid as long as
+// the storage is.
+//
+//   char digest_hex[HexEncodedSize(sizeof(digest))];
+//   StringPiece hex = HexEncode(StringPiece(digest, sizeof(digest)),
+//                               digest_hex);
+//
+//   StringPiece blob;
+//   size_t bad;
+//   if (!Base64Decode(&arena, field, &blob, &bad)) {
+//     return Error(StrCat("bad base64 at offset ", bad));
+//   }
+//
+// Hex and base64 decoding is strict.  It rejects whitespace, characters
+// outside the alphabet, misplaced or missing padding, and encodings whose
+// unused trailing bits are not zero, so every byte string has exactly one
+// accepted encoding.  On failure the decoders report the offset of the
+// first character that is not valid where it is, or the input size if
+// the input ends early.
+//
+// The hex codecs run 16 bytes per step with SSE2.  The base64 codecs run
+// 12 bytes (16 characters) per step with SSSE3 and twice that with AVX2,
+// picked at runtime.  Both use Muła and Lemire's table-lookup
+// formulation.  Every path has a scalar fallback that gives the same
+// answers.
+
+#ifndef FOUNDATION_STRINGS_ESCAPING_H_
+#define FOUNDATION_STRINGS_ESCAPING_H_
+
+#include <stddef.h>
+
+#include <string>
+using std::string;
+
+#include <foundation/base/arena.hpp>
+#include <foundation/strings/stringpiece.hpp>
+
+namespace foundation {
+
+// ----------------------------------------------------------------------
+// Hex
+//    Encodes as lower-case hex.  Decoding accepts either case.
+// ----------------------------------------------------------------------
+
+constexpr size_t HexEncodedSize(size_t n) { return 2 * n; }
+constexpr size_t HexDecodedMaxSize(size_t n) { return n / 2; }
+
+StringPiece HexEncode(StringPiece src, char* out);
+StringPiece HexEncode(Arena* arena, StringPiece src);
+
+// Returns false for odd-length input or a non-hex character, and then
+// sets *error_offset if it is not NULL.  *decoded is set only on success.
+bool HexDecode(StringPiece src, char* out, StringPiece* decoded,
+               size_t* error_offset = NULL);
+bool HexDecode(Arena* arena, StringPiece src, StringPiece* decoded,
+               size_t* error_offset = NULL);
+
+// ----------------------------------------------------------------------
+// Base64
+//    Base64Encode() uses the standard alphabet (A-Z a-z 0-9 + /) and pads
+//    to a multiple of 4 characters with '='.  Base64Decode() requires
+//    that padding.
+//
+//    Base64UrlEncode() uses the URL- and filename-safe alphabet (- and _
+//    in place of + and /) and does not pad.  Base64UrlDecode() accepts
+//    input with or without padding, but padding that is present must be
+//    complete.
+// ----------------------------------------------------------------------
+
+constexpr size_t Base64EncodedSize(size_t n) { return (n + 2) / 3 * 4; }
+constexpr size_t Base64UrlEncodedSize(size_t n) { return (4 * n + 2) / 3; }
+// Enough for either alphabet, padded or not.
+constexpr size_t Base64DecodedMaxSize(size_t n) { return n / 4 * 3 + n % 4 * 3 / 4; }
+
+StringPiece Base64Encode(StringPiece src, char* out);
+StringPiece Base64Encode(Arena* arena, StringPiece src);
+StringPiece Base64UrlEncode(StringPiece src, char* out);
+StringPiece Base64UrlEncode(Arena* arena, StringPiece src);
+
+// As HexDecode().  The Arena forms give back any space they do not use.
+bool Base64Decode(StringPiece src, char* out, StringPiece* decoded,
+                  size_t* error_offset = NULL);
+bool Base64Decode(Arena* arena, StringPiece src, StringPiece* decoded,
+                  size_t* error_offset = NULL);
+bool Base64UrlDecode(StringPiece src, char* out, StringPiece* decoded,
+                     size_t* error_offset = NULL);
+bool Base64UrlDecode(Arena* arena, StringPiece src, StringPiece* decoded,
+                     size_t* error_offset = NULL);
+
+// ----------------------------------------------------------------------
+// C and JSON escaping
+//    The *AndAppend() functions append to *dest, as StrAppend() does,
+//    so one record can be assembled in a single string:
+//
+//      StrAppend(&line, "{\"msg\":\"");
+//      JsonEscapeAndAppend(message, &line);
+//      line += "\"}";
+//
+//    The input is scanned 16 or 32 bytes at a time for characters that
+//    need escaping (a CharSet scan; see charset.hpp), and the runs between
+//    them are appended whole.  Text with nothing to escape costs one scan
+//    and one append.
+//
+//    CEscape() writes \n \r \t \" \' \\ for those characters and a
+//    3-digit octal escape for every other byte outside 0x20..0x7E.
+//    CUnescapeAndAppend() also accepts \a \b \f \v \? and \x with one or two
+//    hex digits.
+//
+//    JsonEscape() escapes what RFC 8259 requires: " \ and the control
+//    characters, using \b \f \n \r \t where they exist and \u00XX
+//    otherwise.  Other bytes, including UTF-8, pass through.
+//    JsonUnescapeAndAppend() takes the contents of a JSON string (without the
+//    quotes), turns \uXXXX escapes and surrogate pairs into UTF-8, and
+//    rejects unescaped quotes and control characters.
+//
+//    The unescapers return false for malformed input and set
+//    *error_offset, if it is not NULL, to the offset of the offending
+//    escape or character.  *dest is then left as it was.
+// ----------------------------------------------------------------------
+
+void CEscapeAndAppend(StringPiece src, string* dest);
+string CEscape(StringPiece src);
+bool CUnescapeAndAppend(StringPiece src, string* dest,
+                        size_t* error_offset = NULL);
+
+void JsonEscapeAndAppend(StringPiece src, string* dest);
+string JsonEscape(StringPiece src);
+bool JsonUnescapeAndAppend(StringPiece src, string* dest,
+                           size_t* error_offset = NULL);
+
+}  // namespace foundation
+
+#endif  // FOUNDATION_STRINGS_ESCAPING_H_
@@ -0,0 +1,40 @@
+// Fast non-cryptographic hashing of byte strings.
+//
+// Hash64() is in the wyhash family for short inputs: a handful of
+// unaligned 64-bit loads folded with 64x64->128-bit multiplies, so a
+// typical key costs a few nanoseconds and no loop.  Long inputs switch to
+// eight independent multiply-accumulate lanes in the style of XXH3, which
+// the SSE2 and AVX2 kernels run two or four lanes per instruction.  Every
+// kernel computes the same function, so hashes do not depend on the CPU.
+//
+// The result is stable within a build but is not a persistent format and
+// must not be used where an attacker chooses the keys and the cost of
+// collisions matters.
+//
+// For StringPiece keys, std::hash<StringPiece> and StringPieceHash in
+// stringpiece.hpp call this.
+
+#ifndef FOUNDATION_STRINGS_HASH_H_
+#define FOUNDATION_STRINGS_HASH_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace foundation {
+
+uint64_t Hash64(const char* data, size_t len, uint64_t seed);
+
+inline uint64_t Hash64(const char* data, size_t len) {
+  return Hash64(data, len, 0);
+}
+
+// Combines two hashes, e.g. to hash a pair of fields.
+inline uint64_t HashCombine(uint64_t seed, uint64_t h) {
+  const uint64_t kMul = 0x9E3779B97F4A7C15ULL;
+  uint64_t x = (seed ^ h) * kMul;
+  return x ^ (x >> 32);
+}
+
+}  // namespace foundation
+
+#endif  // FOUNDATION_STRINGS_HASH_H_
@@ -0,0 +1,151 @@
+
+#ifndef FOUNDATION_STRINGS_INTERN_H_
+#define FOUNDATION_STRINGS_INTERN_H_
+
+#include <foundation/base/arena.hpp>
+#include <foundation/base/macros.hpp>
+#include <foundation/strings/stringpiece.hpp>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+
+namespace foundation {
+
+namespace internal {
+
+// Interned strings live in the pool's arena as a header followed by the
+// characters and a '\0'.
+struct InternEntry {
+  uint64_t hash;
+  size_t size;
+  const char* data() const { return reinterpret_cast<const char*>(this + 1); }
+};
+
+}  // namespace internal
+
+// ----------------------------------------------------------------------
+// InternedString
+//    A handle to a string owned by an InternPool.  Each distinct string is
+//    stored once, so two handles from the same pool are equal exactly when
+//    they point at the same entry: equality, ordering and hashing are all
+//    a pointer operation, with no string compare.  Handles are trivially
+//    copyable and stay valid for the lifetime of the pool.
+//
+//    Ordering is by address, which is consistent but not lexicographic.
+//    This makes InternedString usable directly as a key of a std::map
+//    (e.g. CommandDispatcher<InternedString, ...>) or, through the
+//    std::hash specialization below, an unordered container.
+//
+//    A default-constructed handle is null and compares unequal to every
+//    interned string, including "".
+// ----------------------------------------------------------------------
+class InternedString {
+ public:
+  InternedString() : entry_(NULL) {}
+
+  bool is_null() const { return entry_ == NULL; }
+  StringPiece piece() const {
+    return entry_ ? StringPiece(entry_->data(), entry_->size) : StringPiece();
+  }
+  // '\0'-terminated, or "" for a null handle.
+  const char* c_str() const { return entry_ ? entry_->data() : ""; }
+  size_t size() const { return entry_ ? entry_->size : 0; }
+  uint64_t hash() const { return entry_ ? entry_->hash : 0; }
+
+  bool operator==(InternedString other) const { return entry_ == other.entry_; }
+  bool operator!=(InternedString other) const { return entry_ != other.entry_; }
+  bool operator<(InternedString other) const {
+    return std::less<const internal::InternEntry*>()(entry_, other.entry_);
+  }
+
+ private:
+  friend class InternPool;
+  explicit InternedString(const internal::InternEntry* entry) : entry_(entry) {}
+
+  const internal::InternEntry* entry_;
+};
+
+// ----------------------------------------------------------------------
+// InternPool
+//    Maps strings to stable InternedString handles.  Safe to use from any
+//    number of threads.
+//
+//    The pool is split into shards by hash, each with its own lock, arena
+//    and open-addressed table.  Looking up a string that is already
+//    interned - the common case for command names, logger tags and metric
+//    names - takes no lock at all: tables are published atomically and
+//    entries are never removed, so readers probe without synchronization
+//    and only fall back to the shard lock on a miss.
+//
+//      static InternPool pool;
+//      InternedString cmd = pool.Intern(line_piece);
+//      if (cmd == kQuit) ...
+//
+//    Strings are never released before the pool is destroyed.
+// ----------------------------------------------------------------------
+class InternPool {
+ public:
+  InternPool();
+  ~InternPool();
+
+  // Returns the handle for s, adding it on first use.
+  InternedString Intern(StringPiece s);
+
+  // Returns the handle for s, or a null handle if it was never interned.
+  InternedString Find(StringPiece s) const;
+
+  // Number of distinct strings interned.
+  size_t size() const;
+
+  // A process-wide pool, for handles that are shared between modules.
+  static InternPool* Default();
+
+ private:
+  static const int kShardBits = 4;
+  static const int kShards = 1 << kShardBits;
+
+  struct Table {
+    explicit Table(size_t capacity);
+    const size_t mask;
+    std::vector<std::atomic<const internal::InternEntry*> > slots;
+  };
+
+  struct Shard {
+    Shard();
+    std::atomic<Table*> table;
+    std::mutex mutex;            // Guards everything below and writes.
+    Arena arena;
+    std::vector<Table*> retired; // Old tables, which readers may still use.
+    size_t count;
+  };
+
+  static const internal::InternEntry* Lookup(const Table* table,
+                                             StringPiece s, uint64_t hash);
+  static void Insert(Table* table, const internal::InternEntry* entry);
+  Shard& ShardFor(uint64_t hash) const {
+    return shards_[hash >> (64 - kShardBits)];
+  }
+
+  mutable Shard shards_[kShards];
+
+  DISALLOW_COPY_AND_ASSIGN(InternPool);
+};
+
+}  // namespace foundation
+
+namespace std {
+template <>
+struct hash<foundation::InternedString> {
+  size_t operator()(foundation::InternedString s) const {
+    return static_cast<size_t>(s.hash());
+  }
+};
+}  // namespace std
+
+#endif  // FOUNDATION_STRINGS_INTERN_H_
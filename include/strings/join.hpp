@@ -0,0 +1,240 @@
+
+#ifndef FOUNDATION_STRINGS_JOIN_H_
+#define FOUNDATION_STRINGS_JOIN_H_
+
+#include <foundation/strings/numbers.hpp>
+#include <foundation/strings/strcat.hpp>
+#include <foundation/strings/stringpiece.hpp>
+
+#include <string.h>
+
+#include <initializer_list>
+#include <iterator>
+#include <string>
+using std::string;
+#include <type_traits>
+#include <utility>
+
+
+namespace foundation {
+
+// ----------------------------------------------------------------------
+// StrJoin()
+//    Joins the elements of a range with a separator:
+//
+//      std::vector<string> v = {"a", "b", "c"};
+//      StrJoin(v, ", ");                          // "a, b, c"
+//      StrJoin({1, 2, 3}, "-");                   // "1-2-3"
+//      StrJoin(StrSplit(line, ','), "|");         // re-delimit
+//      StrJoin(m, ",", PairFormatter("="));       // "k1=v1,k2=v2"
+//
+//    The range may be any container, a StrSplit() result, an
+//    initializer list, or an iterator pair.  Each element is appended by
+//    a formatter: any callable with the signature
+//      void (string* out, const T& element)
+//    The default, AlphaNumFormatter, accepts whatever AlphaNum accepts
+//    (strings, StringPieces, C strings and integers).
+//
+//    Over a multi-pass range, StrJoin sizes the output before writing
+//    anything, so the result is allocated once.  String-like elements
+//    are sized exactly and copied straight into place; integers are
+//    sized by digit count; anything else is left to the formatter to
+//    grow the string.
+// ----------------------------------------------------------------------
+
+struct AlphaNumFormatter {
+  template <typename T>
+  void operator()(string* out, const T& t) const {
+    StrAppend(out, t);
+  }
+};
+
+namespace internal {
+
+template <typename FirstFormatter, typename SecondFormatter>
+class PairFormatterImpl {
+ public:
+  PairFormatterImpl(FirstFormatter first, StringPiece separator,
+                    SecondFormatter second)
+      : first_(first), separator_(separator), second_(second) {}
+
+  template <typename Pair>
+  void operator()(string* out, const Pair& p) const {
+    first_(out, p.first);
+    out->append(separator_.data(), separator_.size());
+    second_(out, p.second);
+  }
+
+ private:
+  FirstFormatter first_;
+  StringPiece separator_;
+  SecondFormatter second_;
+};
+
+}  // namespace internal
+
+// Formats a std::pair (e.g. a map entry) as <first><separator><second>,
+// each half with its own formatter (AlphaNumFormatter by default).
+inline internal::PairFormatterImpl<AlphaNumFormatter, AlphaNumFormatter>
+PairFormatter(StringPiece separator) {
+  return internal::PairFormatterImpl<AlphaNumFormatter, AlphaNumFormatter>(
+      AlphaNumFormatter(), separator, AlphaNumFormatter());
+}
+
+template <typename FirstFormatter, typename SecondFormatter>
+internal::PairFormatterImpl<FirstFormatter, SecondFormatter>
+PairFormatter(FirstFormatter first, StringPiece separator,
+              SecondFormatter second) {
+  return internal::PairFormatterImpl<FirstFormatter, SecondFormatter>(
+      first, separator, second);
+}
+
+namespace internal {
+
+// Size estimates for the pre-pass.  Exact for string-like and integral
+// values, zero (meaning "unknown") for everything else.
+template <typename T>
+typename std::enable_if<std::is_convertible<const T&, StringPiece>::value,
+                        size_t>::type
+JoinSizeHint(const T& t) {
+  return StringPiece(t).size();
+}
+
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value &&
+                            !std::is_convertible<const T&, StringPiece>::value,
+                        size_t>::type
+JoinSizeHint(const T& t) {
+  if (std::is_signed<T>::value && t < 0) {
+    return 1 + DecimalDigitCount(0 - static_cast<uint64_t>(t));
+  }
+  return DecimalDigitCount(static_cast<uint64_t>(t));
+}
+
+template <typename T>
+typename std::enable_if<!std::is_integral<T>::value &&
+                            !std::is_convertible<const T&, StringPiece>::value,
+                        size_t>::type
+JoinSizeHint(const T&) {
+  return 0;
+}
+
+template <typename Iterator>
+struct IsMultiPass
+    : std::is_base_of<std::forward_iterator_tag,
+                      typename std::iterator_traits<Iterator>::iterator_category> {
+};
+
+// Generic path: reserve from the estimates, then let the formatter append.
+template <typename Iterator, typename Formatter>
+string JoinAlgorithm(Iterator first, Iterator last, StringPiece separator,
+                     Formatter&& formatter) {
+  string result;
+  if (IsMultiPass<Iterator>::value && first != last) {
+    size_t estimate = 0;
+    size_t count = 0;
+    for (Iterator it = first; it != last; ++it, ++count) {
+      estimate += JoinSizeHint(*it);
+    }
+    result.reserve(estimate + (count - 1) * separator.size());
+  }
+  StringPiece sep;
+  for (Iterator it = first; it != last; ++it) {
+    result.append(sep.data(), sep.size());
+    formatter(&result, *it);
+    sep = separator;
+  }
+  return result;
+}
+
+// String-like elements with the default formatter: size exactly, resize
+// once and copy each piece into place.
+template <typename Iterator>
+string JoinStringPieces(Iterator first, Iterator last, StringPiece separator) {
+  string result;
+  if (first == last) return result;
+
+  size_t length = 0;
+  for (Iterator it = first; it != last; ++it) {
+    if (it != first) length += separator.size();
+    length += StringPiece(*it).size();
+  }
+  result.resize(length);
+
+  char* out = &result[0];
+  for (Iterator it = first; it != last; ++it) {
+    if (it != first) {
+      memcpy(out, separator.data(), separator.size());
+      out += separator.size();
+    }
+    const StringPiece piece(*it);
+    if (piece.size() > 0) {
+      memcpy(out, piece.data(), piece.size());
+      out += piece.size();
+    }
+  }
+  return result;
+}
+
+template <typename Iterator>
+string JoinDefault(Iterator first, Iterator last, StringPiece separator,
+                   std::true_type /* string-like, multi-pass */) {
+  return JoinStringPieces(first, last, separator);
+}
+
+template <typename Iterator>
+string JoinDefault(Iterator first, Iterator last, StringPiece separator,
+                   std::false_type) {
+  return JoinAlgorithm(first, last, separator, AlphaNumFormatter());
+}
+
+}  // namespace internal
+
+template <typename Iterator, typename Formatter>
+string StrJoin(Iterator first, Iterator last, StringPiece separator,
+               Formatter&& formatter) {
+  return internal::JoinAlgorithm(first, last, separator,
+                                 std::forward<Formatter>(formatter));
+}
+
+template <typename Iterator>
+string StrJoin(Iterator first, Iterator last, StringPiece separator) {
+  typedef typename std::iterator_traits<Iterator>::value_type Value;
+  typedef std::integral_constant<
+      bool, std::is_convertible<const Value&, StringPiece>::value &&
+                internal::IsMultiPass<Iterator>::value>
+      Direct;
+  return internal::JoinDefault(first, last, separator, Direct());
+}
+
+template <typename Range, typename Formatter>
+string StrJoin(const Range& range, StringPiece separator,
+               Formatter&& formatter) {
+  using std::begin;
+  using std::end;
+  return StrJoin(begin(range), end(range), separator,
+                 std::forward<Formatter>(formatter));
+}
+
+template <typename Range>
+string StrJoin(const Range& range, StringPiece separator) {
+  using std::begin;
+  using std::end;
+  return StrJoin(begin(range), end(range), separator);
+}
+
+template <typename T, typename Formatter>
+string StrJoin(std::initializer_list<T> il, StringPiece separator,
+               Formatter&& formatter) {
+  return StrJoin(il.begin(), il.end(), separator,
+                 std::forward<Formatter>(formatter));
+}
+
+template <typename T>
+string StrJoin(std::initializer_list<T> il, StringPiece separator) {
+  return StrJoin(il.begin(), il.end(), separator);
+}
+
+}  // namespace foundation
+
+#endif  // FOUNDATION_STRINGS_JOIN_H_
@@ -49,6 +49,11 @@ namespace foundation {
 //    to pass to FastTimeToBuffer() a time whose year cannot be
 //    represented in 4 digits. In this case, the output buffer
 //    will contain the string "Invalid:<value>"
+//
+//    FastTimeToBuffer() and FastIso8601TimeToBuffer() format in UTC
+//    and never call gmtime_r() or strftime().  Each thread caches the
+//    text of the last second it formatted, so consecutive calls within
+//    one second cost a copy (and, for ISO-8601, six digits).
 // ----------------------------------------------------------------------
 
 // Previously documented minimums -- the buffers provided must be at least this
@@ -56,6 +61,7 @@ namespace foundation {
 //     Int32, UInt32:                   12 bytes
 //     Int64, UInt64, Hex, Int, Uint:   22 bytes
 //     Time:                            30 bytes
+//     Iso8601Time:                     29 bytes
 //     Hex32:                            9 bytes
 //     Hex64:                           17 bytes
 // Use kFastToBufferSize rather than hardcoding constants.
@@ -68,6 +74,13 @@ char* FastTimeToBuffer(time_t t, char* buffer);
 char* FastHex64ToBuffer(uint64_t i, char* buffer);
 char* FastHex32ToBuffer(uint32_t i, char* buffer);
 
+// ISO-8601 in UTC with microseconds, e.g. "1994-11-06T08:49:37.000123Z".
+// microseconds must be in [0, 1000000).  Times whose year does not fit in
+// 4 digits come out as "Invalid:<value>", as for FastTimeToBuffer(), which
+// with a 20-character value is one byte longer than a valid time: the
+// buffer must hold 29 bytes.
+char* FastIso8601TimeToBuffer(time_t t, int32_t microseconds, char* buffer);
+
 // ----------------------------------------------------------------------
 // FastInt32ToBufferLeft()
 // FastUInt32ToBufferLeft()
@@ -89,6 +102,23 @@ char* FastUInt32ToBufferLeft(uint32_t i, char* buffer);    // at least 12 bytes
 char* FastInt64ToBufferLeft(int64_t i, char* buffer);    // at least 22 bytes
 char* FastUInt64ToBufferLeft(uint64_t i, char* buffer);    // at least 22 bytes
 
+// ----------------------------------------------------------------------
+// DecimalDigitCount()
+//    The number of digits FastUInt64ToBufferLeft() writes for i, which
+//    lets callers size an output buffer before formatting into it.
+// ----------------------------------------------------------------------
+inline int DecimalDigitCount(uint64_t i) {
+  int n = 1;
+  for (;;) {
+    if (i < 10) return n;
+    if (i < 100) return n + 1;
+    if (i < 1000) return n + 2;
+    if (i < 10000) return n + 3;
+    i /= 10000;
+    n += 4;
+  }
+}
+
 // Just define these in terms of the above.
 
 inline char* FastInt32ToBuffer(int32_t i, char* buffer) {
@@ -218,12 +248,28 @@ inline uint64_t ParseLeadingUDec64Value(const string& str, uint64_t deflt) {
 //    A simple parser for double values. Returns the parsed value
 //    if a valid double is found; else returns deflt. It does not
 //    check if str is entirely consumed.
+//    Leading whitespace is skipped.  Values that overflow to infinity or
+//    underflow to zero return deflt, as strtod() would flag with ERANGE.
+//    Unlike strtod() the decimal point is always '.', whatever the
+//    locale, and the StringPiece form does not need a '\0' terminator.
 // --------------------------------------------------------------------
 double ParseLeadingDoubleValue(const char* str, double deflt);
+double ParseLeadingDoubleValue(StringPiece str, double deflt);
 inline double ParseLeadingDoubleValue(const string& str, double deflt) {
-  return ParseLeadingDoubleValue(str.c_str(), deflt);
+  return ParseLeadingDoubleValue(StringPiece(str), deflt);
 }
 
+// ----------------------------------------------------------------------
+// ParseDoublePrefix
+//    Parses the longest prefix of text that is a decimal floating point
+//    number ([+-]digits[.digits][(e|E)[+-]digits], or inf, infinity, nan
+//    in any case) into *value and returns the number of chars consumed,
+//    or 0 if text does not begin with a number.  Does not skip
+//    whitespace.  The result is always correctly rounded; out of range
+//    values become +-inf or +-0.  Hexadecimal floats are not accepted.
+// --------------------------------------------------------------------
+stringpiece_ssize_type ParseDoublePrefix(StringPiece text, double* value);
+
 // ----------------------------------------------------------------------
 // ParseLeadingBoolValue()
 //    A recognizer of boolean string values. Returns the parsed value
@@ -366,7 +412,7 @@ string ItoaKMGT(int64_t i);
 //    -inf and inf (or unchanged, depending on dont_modify_unbounded)
 //    if unbounded. Output params are undefined if false is
 //    returned. len is the input length, or -1 if text is
-//    '\0'-terminated, which is more efficient.
+//    '\0'-terminated.
 // ----------------------------------------------------------------------
 struct DoubleRangeOptions {
   const char* separators;
@@ -1,8 +1,11 @@
 #ifndef FOUNDATION_STRING_SPLIT_HPP__
 #define FOUNDATION_STRING_SPLIT_HPP__
 
+#include <foundation/strings/stringpiece.hpp>
+
 #include <algorithm>
 #include <iomanip>
+#include <iterator>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -14,8 +17,8 @@ namespace foundation
 inline std::vector<std::string > split(std::string const& str, const std::string& delimiter = "\n") {
 	std::vector<std::string > tokens;
 
-	auto start = 0U;
-	auto end = str.find(delimiter);
+	std::string::size_type start = 0;
+	std::string::size_type end = str.find(delimiter);
 	while (end != std::string::npos) {
 		tokens.push_back(str.substr(start, end - start));
 		start = end + delimiter.size();
@@ -29,6 +32,212 @@ inline std::vector<std::string > split(std::string const& str, const std::string
 	return tokens;
 }
 
+// ----------------------------------------------------------------------
+// StrSplit()
+//    Splits text into a lazy, forward-iterable range of StringPiece
+//    tokens that point into text; nothing is copied and nothing is
+//    allocated, so text must outlive the range and its tokens.
+//
+//      for (StringPiece field : StrSplit(line, ',')) { ... }
+//      for (StringPiece word : StrSplit(line, ByAnyChar(" \t"), SkipEmpty())) { ... }
+//
+//    The delimiter is one of the policies below; a char converts to
+//    ByChar, and a string or StringPiece to ByString.  Unlike split(),
+//    every token is produced, including empty ones: "a,,b," gives
+//    "a", "", "b", "" and an empty text gives a single empty token.  Pass
+//    SkipEmpty() to drop the empty tokens.  A string delimiter is not
+//    copied either, so it too must outlive the range.
+//
+//    A delimiter policy is any type with a member
+//      StringPiece Find(StringPiece text, size_t pos) const;
+//    returning the first delimiter at or after pos, or a zero-length piece
+//    at text.end() if there is none.
+// ----------------------------------------------------------------------
+
+namespace internal
+{
+
+// Shared by the policies: returns the match at 'found', or end-of-text.
+// An empty delimiter splits text into single characters.
+inline StringPiece DelimiterAt(StringPiece text, size_t pos, size_t found, size_t length) {
+	if (length == 0 && text.size() > 0) {
+		return StringPiece(text.data() + pos + 1, 0);
+	}
+	if (found == StringPiece::npos) {
+		return StringPiece(text.data() + text.size(), 0);
+	}
+	return StringPiece(text.data() + found, length);
+}
+
+}
+
+// Splits on a single character.
+struct ByChar {
+	explicit ByChar(char c) : c_(c) {}
+
+	StringPiece Find(StringPiece text, size_t pos) const {
+		size_t found = static_cast<size_t>(text.find(c_, pos));
+		return internal::DelimiterAt(text, pos, found, 1);
+	}
+
+private:
+	char c_;
+};
+
+// Splits on any one of a set of characters.
+struct ByAnyChar {
+	explicit ByAnyChar(StringPiece chars) : chars_(chars) {}
+
+	StringPiece Find(StringPiece text, size_t pos) const {
+		size_t found = static_cast<size_t>(text.find_first_of(chars_, pos));
+		return internal::DelimiterAt(text, pos, found, chars_.empty() ? 0 : 1);
+	}
+
+private:
+	StringPiece chars_;
+};
+
+// Splits on a literal string.
+struct ByString {
+	explicit ByString(StringPiece delimiter) : delimiter_(delimiter) {}
+
+	StringPiece Find(StringPiece text, size_t pos) const {
+		size_t found = static_cast<size_t>(text.find(delimiter_, pos));
+		return internal::DelimiterAt(text, pos, found, delimiter_.size());
+	}
+
+private:
+	StringPiece delimiter_;
+};
+
+// Token predicates.
+struct AllowEmpty {
+	bool operator()(StringPiece) const { return true; }
+};
+
+struct SkipEmpty {
+	bool operator()(StringPiece token) const { return !token.empty(); }
+};
+
+namespace internal
+{
+
+template <typename Delimiter>
+struct SelectDelimiter { typedef Delimiter type; };
+template <> struct SelectDelimiter<char> { typedef ByChar type; };
+template <> struct SelectDelimiter<char*> { typedef ByString type; };
+template <> struct SelectDelimiter<const char*> { typedef ByString type; };
+template <> struct SelectDelimiter<std::string> { typedef ByString type; };
+template <> struct SelectDelimiter<StringPiece> { typedef ByString type; };
+template <size_t N> struct SelectDelimiter<char[N]> { typedef ByString type; };
+
+}
+
+template <typename Delimiter, typename Predicate = AllowEmpty>
+class SplitRange {
+public:
+	class const_iterator {
+	public:
+		typedef std::forward_iterator_tag iterator_category;
+		typedef StringPiece value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef const StringPiece* pointer;
+		typedef const StringPiece& reference;
+
+		const_iterator() : range_(NULL), pos_(0), state_(kEnd) {}
+
+		reference operator*() const { return curr_; }
+		pointer operator->() const { return &curr_; }
+
+		const_iterator& operator++() {
+			const StringPiece text = range_->text_;
+			do {
+				if (state_ == kLast) {
+					state_ = kEnd;
+					pos_ = text.size();
+					return *this;
+				}
+				StringPiece d = range_->delimiter_.Find(text, pos_);
+				if (d.data() == text.data() + text.size()) {
+					state_ = kLast;
+				}
+				curr_ = StringPiece(text.data() + pos_, d.data() - (text.data() + pos_));
+				pos_ += curr_.size() + d.size();
+			} while (!range_->predicate_(curr_));
+			return *this;
+		}
+
+		const_iterator operator++(int) {
+			const_iterator old = *this;
+			++*this;
+			return old;
+		}
+
+		bool operator==(const_iterator const& other) const {
+			return state_ == other.state_ && pos_ == other.pos_;
+		}
+		bool operator!=(const_iterator const& other) const {
+			return !(*this == other);
+		}
+
+	private:
+		friend class SplitRange;
+		enum State { kMore, kLast, kEnd };
+
+		const_iterator(SplitRange const* range, State state)
+			: range_(range), pos_(state == kEnd ? range->text_.size() : 0), state_(state) {
+			if (state_ != kEnd) {
+				++*this;
+			}
+		}
+
+		SplitRange const* range_;
+		size_t pos_;
+		State state_;
+		StringPiece curr_;
+	};
+	typedef const_iterator iterator;
+
+	SplitRange(StringPiece text, Delimiter delimiter, Predicate predicate)
+		: text_(text), delimiter_(delimiter), predicate_(predicate) {}
+
+	// Iterators point back at the range, so keep it alive while iterating.
+	const_iterator begin() const { return const_iterator(this, const_iterator::kMore); }
+	const_iterator end() const { return const_iterator(this, const_iterator::kEnd); }
+
+	StringPiece text() const { return text_; }
+
+	// Convenience for callers that do need to materialize the tokens, e.g.
+	// to<std::vector<std::string> >() or to<std::vector<StringPiece> >().
+	template <typename Container>
+	Container to() const {
+		typedef typename Container::value_type Value;
+		Container out;
+		for (const_iterator it = begin(); it != end(); ++it) {
+			out.insert(out.end(), Value(it->data(), it->size()));
+		}
+		return out;
+	}
+
+private:
+	StringPiece text_;
+	Delimiter delimiter_;
+	Predicate predicate_;
+};
+
+template <typename Delimiter, typename Predicate>
+SplitRange<typename internal::SelectDelimiter<Delimiter>::type, Predicate>
+StrSplit(StringPiece text, Delimiter const& delimiter, Predicate predicate) {
+	typedef typename internal::SelectDelimiter<Delimiter>::type Policy;
+	return SplitRange<Policy, Predicate>(text, Policy(delimiter), predicate);
+}
+
+template <typename Delimiter>
+SplitRange<typename internal::SelectDelimiter<Delimiter>::type>
+StrSplit(StringPiece text, Delimiter const& delimiter) {
+	return StrSplit(text, delimiter, AllowEmpty());
+}
+
 }
 
 #endif // FOUNDATION_STRING_SPLIT_HPP__
@@ -1,16 +1,153 @@
 
 #include <foundation/strings/stringpiece.hpp>
+#include <foundation/strings/charset.hpp>
 
 #include <string.h>
 #include <algorithm>
 #include <climits>
+#include <ostream>
 #include <string>
 using std::string;
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define STRINGPIECE_HAVE_X86_SIMD 1
+#endif
+
 //#include <glog/logging.h>
 
 namespace foundation {
 
+// ----------------------------------------------------------------------
+// Substring search
+//
+// The vector kernels use the "first and last byte" filter: compare a
+// block of haystack positions against the needle's first byte and, at
+// an offset of needle length - 1, against its last byte.  Only positions
+// where both match get a full memcmp.  Two independent bytes reject far
+// more false candidates than memchr() on the first byte alone, which is
+// what makes repetitive inputs degrade.  The kernel is picked once at
+// runtime from the CPU's features.
+//
+// All kernels return a pointer to the first match of needle[0, k) in
+// haystack[0, n), or NULL, and require 2 <= k <= n.
+// ----------------------------------------------------------------------
+
+typedef const char* (*SubstringSearchFn)(const char* haystack, size_t n,
+                                         const char* needle, size_t k);
+
+static const char* SearchScalar(const char* haystack, size_t n,
+                                const char* needle, size_t k) {
+  const char* start = haystack;
+  const char* const end_pos = haystack + n - k + 1;
+  // The cast is used here to work around the fact that memchr returns a
+  // void* on Posix-compliant systems and const void* on Windows.
+  while (const char* match = static_cast<const char*>(
+             memchr(start, needle[0], end_pos - start))) {
+    if (memcmp(match, needle, k) == 0) {
+      return match;
+    }
+    start = match + 1;
+  }
+  return NULL;
+}
+
+#ifdef STRINGPIECE_HAVE_X86_SIMD
+
+__attribute__((target("sse2")))
+static const char* SearchSse2(const char* haystack, size_t n,
+                              const char* needle, size_t k) {
+  const __m128i first = _mm_set1_epi8(needle[0]);
+  const __m128i last = _mm_set1_epi8(needle[k - 1]);
+  const size_t candidates = n - k + 1;
+
+  size_t i = 0;
+  for (; i + 16 <= candidates; i += 16) {
+    const __m128i block_first =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(haystack + i));
+    const __m128i block_last =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(haystack + i + k - 1));
+    unsigned mask = _mm_movemask_epi8(
+        _mm_and_si128(_mm_cmpeq_epi8(first, block_first),
+                      _mm_cmpeq_epi8(last, block_last)));
+    while (mask != 0) {
+      const unsigned bit = __builtin_ctz(mask);
+      if (memcmp(haystack + i + bit + 1, needle + 1, k - 2) == 0) {
+        return haystack + i + bit;
+      }
+      mask &= mask - 1;
+    }
+  }
+  if (i == candidates) return NULL;
+  return SearchScalar(haystack + i, n - i, needle, k);
+}
+
+__attribute__((target("avx2")))
+static const char* SearchAvx2(const char* haystack, size_t n,
+                              const char* needle, size_t k) {
+  const __m256i first = _mm256_set1_epi8(needle[0]);
+  const __m256i last = _mm256_set1_epi8(needle[k - 1]);
+  const size_t candidates = n - k + 1;
+
+  size_t i = 0;
+  for (; i + 32 <= candidates; i += 32) {
+    const __m256i block_first =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(haystack + i));
+    const __m256i block_last = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(haystack + i + k - 1));
+    unsigned mask = _mm256_movemask_epi8(
+        _mm256_and_si256(_mm256_cmpeq_epi8(first, block_first),
+                         _mm256_cmpeq_epi8(last, block_last)));
+    while (mask != 0) {
+      const unsigned bit = __builtin_ctz(mask);
+      if (memcmp(haystack + i + bit + 1, needle + 1, k - 2) == 0) {
+        return haystack + i + bit;
+      }
+      mask &= mask - 1;
+    }
+  }
+  if (i == candidates) return NULL;
+  return SearchSse2(haystack + i, n - i, needle, k);
+}
+
+#if !defined(__GLIBC__) && defined(__SSE2__)
+// Index of the last c in p[0, last], or -1.  Used where there is no
+// memrchr(); SSE2 is part of every x86-64 so needs no dispatch.
+static stringpiece_ssize_type RFindCharSse2(const char* p,
+                                            stringpiece_ssize_type last,
+                                            char c) {
+  const __m128i needle = _mm_set1_epi8(c);
+  stringpiece_ssize_type i = last + 1;
+  while (i >= 16) {
+    i -= 16;
+    const unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(
+        needle, _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i))));
+    if (mask != 0) return i + 31 - __builtin_clz(mask);
+  }
+  while (i > 0) {
+    if (p[--i] == c) return i;
+  }
+  return -1;
+}
+#endif  // !__GLIBC__ && __SSE2__
+
+#endif  // STRINGPIECE_HAVE_X86_SIMD
+
+static SubstringSearchFn ResolveSubstringSearch() {
+#ifdef STRINGPIECE_HAVE_X86_SIMD
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) return SearchAvx2;
+  if (__builtin_cpu_supports("sse2")) return SearchSse2;
+#endif
+  return SearchScalar;
+}
+
+static inline const char* SubstringSearch(const char* haystack, size_t n,
+                                          const char* needle, size_t k) {
+  static const SubstringSearchFn search = ResolveSubstringSearch();
+  return search(haystack, n, needle, k);
+}
+
 std::ostream& operator<<(std::ostream& o, StringPiece piece) {
   o.write(piece.data(), piece.size());
   return o;
@@ -69,18 +206,13 @@ stringpiece_ssize_type StringPiece::find(StringPiece s, size_type pos) const {
   if (left < s.length_) {
     return npos;
   }
-  const char* end_pos = start + left - s.length_ + 1;
-  // The cast is used here to work around the fact that memchr returns a
-  // void* on Posix-compliant systems and const void* on Windows.
-  while (auto match = static_cast<const char*>(memchr(start, s.ptr_[0],
-                                                      end_pos - start))) {
-    if (memcmp(match, s.ptr_, s.length_) == 0) {
-      return match - ptr_;
-    } else {
-      start = match + 1;
-    }
+  if (s.length_ == 1) {
+    const char* match =
+        static_cast<const char*>(memchr(start, s.ptr_[0], left));
+    return match != NULL ? match - ptr_ : npos;
   }
-  return npos;
+  const char* match = SubstringSearch(start, left, s.ptr_, s.length_);
+  return match != NULL ? match - ptr_ : npos;
 }
 
 stringpiece_ssize_type StringPiece::find(char c, size_type pos) const {
@@ -104,68 +236,270 @@ stringpiece_ssize_type StringPiece::rfind(StringPiece s, size_type pos) const {
 
 // Search range is [0..pos] inclusive.  If pos == npos, search everything.
 stringpiece_ssize_type StringPiece::rfind(char c, size_type pos) const {
-  // Note: memrchr() is not available on Windows.
   if (length_ <= 0) return npos;
-  for (stringpiece_ssize_type i =
+  const stringpiece_ssize_type last =
       std::min(pos, static_cast<size_type>(length_ - 1));
-       i >= 0; --i) {
+#if defined(__GLIBC__)
+  // glibc's memrchr() is already vectorized for the running CPU.
+  const char* result =
+      static_cast<const char*>(memrchr(ptr_, c, last + 1));
+  return result != NULL ? result - ptr_ : npos;
+#elif defined(STRINGPIECE_HAVE_X86_SIMD) && defined(__SSE2__)
+  // Note: memrchr() is not available on Windows.
+  const stringpiece_ssize_type result = RFindCharSse2(ptr_, last, c);
+  return result >= 0 ? result : npos;
+#else
+  for (stringpiece_ssize_type i = last; i >= 0; --i) {
     if (ptr_[i] == c) {
       return i;
     }
   }
   return npos;
+#endif
+}
+
+// ----------------------------------------------------------------------
+// Character-set scans
+//
+// The vector kernels classify a block of bytes against a CharSet with
+// two table lookups (PSHUFB): the low nibble of each byte selects a row
+// of the set's nibble table, and the high nibble selects a bit within
+// that row.  See charset.hpp for the table layout.
+//
+// Forward kernels return the index of the first byte of p[0, n) whose
+// membership differs from 'negate', or n.  Reverse kernels return the
+// index of the last such byte, or -1.
+// ----------------------------------------------------------------------
+
+typedef size_t (*CharSetScanFn)(const char* p, size_t n, const CharSet& set,
+                                bool negate);
+typedef stringpiece_ssize_type (*CharSetReverseScanFn)(const char* p,
+                                                       size_t n,
+                                                       const CharSet& set,
+                                                       bool negate);
+
+static size_t ScanCharSetScalar(const char* p, size_t n, const CharSet& set,
+                                bool negate) {
+  for (size_t i = 0; i < n; ++i) {
+    if (set.contains(static_cast<unsigned char>(p[i])) != negate) return i;
+  }
+  return n;
+}
+
+static stringpiece_ssize_type ReverseScanCharSetScalar(const char* p,
+                                                       size_t n,
+                                                       const CharSet& set,
+                                                       bool negate) {
+  for (stringpiece_ssize_type i = n - 1; i >= 0; --i) {
+    if (set.contains(static_cast<unsigned char>(p[i])) != negate) return i;
+  }
+  return -1;
+}
+
+#ifdef STRINGPIECE_HAVE_X86_SIMD
+
+// 0xFF in every byte of 'in' that is a member of the set.
+__attribute__((target("ssse3")))
+static inline __m128i ClassifySsse3(__m128i in, __m128i low_table,
+                                    __m128i high_table) {
+  const __m128i bit_for_high_nibble =
+      _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+  // PSHUFB yields 0 for index bytes with the top bit set, so each table
+  // only answers for its own half of the byte range.
+  const __m128i rows = _mm_or_si128(
+      _mm_shuffle_epi8(low_table, in),
+      _mm_shuffle_epi8(high_table, _mm_xor_si128(in, _mm_set1_epi8(-128))));
+  const __m128i high_nibble =
+      _mm_and_si128(_mm_srli_epi16(in, 4), _mm_set1_epi8(0x0F));
+  const __m128i bit = _mm_shuffle_epi8(bit_for_high_nibble, high_nibble);
+  return _mm_cmpeq_epi8(_mm_and_si128(rows, bit), bit);
 }
 
-// For each character in characters_wanted, sets the index corresponding
-// to the ASCII code of that character to 1 in table.  This is used by
-// the find_.*_of methods below to tell whether or not a character is in
-// the lookup table in constant time.
-// The argument `table' must be an array that is large enough to hold all
-// the possible values of an unsigned char.  Thus it should be be declared
-// as follows:
-//   bool table[UCHAR_MAX + 1]
-static inline void BuildLookupTable(StringPiece characters_wanted,
-                                    bool* table) {
-  const stringpiece_ssize_type length = characters_wanted.length();
-  const char* const data = characters_wanted.data();
-  for (stringpiece_ssize_type i = 0; i < length; ++i) {
-    table[static_cast<unsigned char>(data[i])] = true;
+__attribute__((target("ssse3")))
+static size_t ScanCharSetSsse3(const char* p, size_t n, const CharSet& set,
+                               bool negate) {
+  const __m128i low_table =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(set.low_table()));
+  const __m128i high_table =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(set.high_table()));
+  const unsigned flip = negate ? 0xFFFF : 0;
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    const __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+    const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(
+                              ClassifySsse3(in, low_table, high_table))) ^
+                          flip;
+    if (mask != 0) return i + __builtin_ctz(mask);
   }
+  return i + ScanCharSetScalar(p + i, n - i, set, negate);
+}
+
+__attribute__((target("ssse3")))
+static stringpiece_ssize_type ReverseScanCharSetSsse3(const char* p,
+                                                      size_t n,
+                                                      const CharSet& set,
+                                                      bool negate) {
+  const __m128i low_table =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(set.low_table()));
+  const __m128i high_table =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(set.high_table()));
+  const unsigned flip = negate ? 0xFFFF : 0;
+  size_t i = n;
+  while (i >= 16) {
+    i -= 16;
+    const __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+    const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(
+                              ClassifySsse3(in, low_table, high_table))) ^
+                          flip;
+    if (mask != 0) return i + 31 - __builtin_clz(mask);
+  }
+  return ReverseScanCharSetScalar(p, i, set, negate);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i ClassifyAvx2(__m256i in, __m256i low_table,
+                                   __m256i high_table) {
+  const __m256i bit_for_high_nibble = _mm256_setr_epi8(
+      1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128,
+      1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+  const __m256i rows = _mm256_or_si256(
+      _mm256_shuffle_epi8(low_table, in),
+      _mm256_shuffle_epi8(high_table,
+                          _mm256_xor_si256(in, _mm256_set1_epi8(-128))));
+  const __m256i high_nibble =
+      _mm256_and_si256(_mm256_srli_epi16(in, 4), _mm256_set1_epi8(0x0F));
+  const __m256i bit = _mm256_shuffle_epi8(bit_for_high_nibble, high_nibble);
+  return _mm256_cmpeq_epi8(_mm256_and_si256(rows, bit), bit);
 }
 
+__attribute__((target("avx2")))
+static size_t ScanCharSetAvx2(const char* p, size_t n, const CharSet& set,
+                              bool negate) {
+  // VPSHUFB looks up within each 128-bit lane, so repeat the tables.
+  const __m256i low_table = _mm256_broadcastsi128_si256(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(set.low_table())));
+  const __m256i high_table = _mm256_broadcastsi128_si256(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(set.high_table())));
+  const unsigned flip = negate ? 0xFFFFFFFFu : 0;
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    const __m256i in =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+    const unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(
+                              ClassifyAvx2(in, low_table, high_table))) ^
+                          flip;
+    if (mask != 0) return i + __builtin_ctz(mask);
+  }
+  return i + ScanCharSetSsse3(p + i, n - i, set, negate);
+}
+
+__attribute__((target("avx2")))
+static stringpiece_ssize_type ReverseScanCharSetAvx2(const char* p,
+                                                     size_t n,
+                                                     const CharSet& set,
+                                                     bool negate) {
+  const __m256i low_table = _mm256_broadcastsi128_si256(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(set.low_table())));
+  const __m256i high_table = _mm256_broadcastsi128_si256(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(set.high_table())));
+  const unsigned flip = negate ? 0xFFFFFFFFu : 0;
+  size_t i = n;
+  while (i >= 32) {
+    i -= 32;
+    const __m256i in =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+    const unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(
+                              ClassifyAvx2(in, low_table, high_table))) ^
+                          flip;
+    if (mask != 0) return i + 31 - __builtin_clz(mask);
+  }
+  return ReverseScanCharSetSsse3(p, i, set, negate);
+}
+
+#endif  // STRINGPIECE_HAVE_X86_SIMD
+
+struct CharSetScanners {
+  CharSetScanFn forward;
+  CharSetReverseScanFn reverse;
+};
+
+static CharSetScanners ResolveCharSetScanners() {
+  CharSetScanners scanners = {ScanCharSetScalar, ReverseScanCharSetScalar};
+#ifdef STRINGPIECE_HAVE_X86_SIMD
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    scanners.forward = ScanCharSetAvx2;
+    scanners.reverse = ReverseScanCharSetAvx2;
+  } else if (__builtin_cpu_supports("ssse3")) {
+    scanners.forward = ScanCharSetSsse3;
+    scanners.reverse = ReverseScanCharSetSsse3;
+  }
+#endif
+  return scanners;
+}
+
+static inline const CharSetScanners& GetCharSetScanners() {
+  static const CharSetScanners scanners = ResolveCharSetScanners();
+  return scanners;
+}
+
+stringpiece_ssize_type StringPiece::find_first_of(const CharSet& s,
+                                                  size_type pos) const {
+  if (length_ <= 0 || pos >= static_cast<size_type>(length_)) return npos;
+  const size_t n = length_ - pos;
+  const size_t i = GetCharSetScanners().forward(ptr_ + pos, n, s, false);
+  return i != n ? pos + i : npos;
+}
+
+stringpiece_ssize_type StringPiece::find_first_not_of(const CharSet& s,
+                                                      size_type pos) const {
+  if (length_ <= 0 || pos >= static_cast<size_type>(length_)) return npos;
+  const size_t n = length_ - pos;
+  const size_t i = GetCharSetScanners().forward(ptr_ + pos, n, s, true);
+  return i != n ? pos + i : npos;
+}
+
+stringpiece_ssize_type StringPiece::find_last_of(const CharSet& s,
+                                                 size_type pos) const {
+  if (length_ <= 0) return npos;
+  const size_t n = std::min(pos, static_cast<size_type>(length_ - 1)) + 1;
+  const stringpiece_ssize_type i =
+      GetCharSetScanners().reverse(ptr_, n, s, false);
+  return i >= 0 ? i : npos;
+}
+
+stringpiece_ssize_type StringPiece::find_last_not_of(const CharSet& s,
+                                                     size_type pos) const {
+  if (length_ <= 0) return npos;
+  const size_t n = std::min(pos, static_cast<size_type>(length_ - 1)) + 1;
+  const stringpiece_ssize_type i =
+      GetCharSetScanners().reverse(ptr_, n, s, true);
+  return i >= 0 ? i : npos;
+}
+
+// The StringPiece forms build a CharSet per call; it is much cheaper to
+// build than a 256-entry table, and gets the same vector scan.  Hot
+// callers should keep a CharSet around instead.
+
 stringpiece_ssize_type StringPiece::find_first_of(StringPiece s,
                                                   size_type pos) const {
   if (length_ <= 0 || s.length_ <= 0) {
     return npos;
   }
-  // Avoid the cost of BuildLookupTable() for a single-character search.
+  // Avoid the cost of building a CharSet for a single-character search.
   if (s.length_ == 1) return find_first_of(s.ptr_[0], pos);
 
-  bool lookup[UCHAR_MAX + 1] = { false };
-  BuildLookupTable(s, lookup);
-  for (stringpiece_ssize_type i = pos; i < length_; ++i) {
-    if (lookup[static_cast<unsigned char>(ptr_[i])]) {
-      return i;
-    }
-  }
-  return npos;
+  return find_first_of(CharSet(s.ptr_, s.length_), pos);
 }
 
 stringpiece_ssize_type StringPiece::find_first_not_of(StringPiece s,
                                                       size_type pos) const {
   if (length_ <= 0) return npos;
   if (s.length_ <= 0) return 0;
-  // Avoid the cost of BuildLookupTable() for a single-character search.
+  // Avoid the cost of building a CharSet for a single-character search.
   if (s.length_ == 1) return find_first_not_of(s.ptr_[0], pos);
 
-  bool lookup[UCHAR_MAX + 1] = { false };
-  BuildLookupTable(s, lookup);
-  for (stringpiece_ssize_type i = pos; i < length_; ++i) {
-    if (!lookup[static_cast<unsigned char>(ptr_[i])]) {
-      return i;
-    }
-  }
-  return npos;
+  return find_first_not_of(CharSet(s.ptr_, s.length_), pos);
 }
 
 stringpiece_ssize_type StringPiece::find_first_not_of(char c,
@@ -183,18 +517,10 @@ stringpiece_ssize_type StringPiece::find_first_not_of(char c,
 stringpiece_ssize_type StringPiece::find_last_of(StringPiece s,
                                                  size_type pos) const {
   if (length_ <= 0 || s.length_ <= 0) return npos;
-  // Avoid the cost of BuildLookupTable() for a single-character search.
+  // Avoid the cost of building a CharSet for a single-character search.
   if (s.length_ == 1) return find_last_of(s.ptr_[0], pos);
 
-  bool lookup[UCHAR_MAX + 1] = { false };
-  BuildLookupTable(s, lookup);
-  for (stringpiece_ssize_type i =
-       std::min(pos, static_cast<size_type>(length_ - 1)); i >= 0; --i) {
-    if (lookup[static_cast<unsigned char>(ptr_[i])]) {
-      return i;
-    }
-  }
-  return npos;
+  return find_last_of(CharSet(s.ptr_, s.length_), pos);
 }
 
 stringpiece_ssize_type StringPiece::find_last_not_of(StringPiece s,
@@ -204,17 +530,10 @@ stringpiece_ssize_type StringPiece::find_last_not_of(StringPiece s,
   stringpiece_ssize_type i = std::min(pos, static_cast<size_type>(length_ - 1));
   if (s.length_ <= 0) return i;
 
-  // Avoid the cost of BuildLookupTable() for a single-character search.
+  // Avoid the cost of building a CharSet for a single-character search.
   if (s.length_ == 1) return find_last_not_of(s.ptr_[0], pos);
 
-  bool lookup[UCHAR_MAX + 1] = { false };
-  BuildLookupTable(s, lookup);
-  for (; i >= 0; --i) {
-    if (!lookup[static_cast<unsigned char>(ptr_[i])]) {
-      return i;
-    }
-  }
-  return npos;
+  return find_last_not_of(CharSet(s.ptr_, s.length_), pos);
 }
 
 stringpiece_ssize_type StringPiece::find_last_not_of(char c,
@@ -0,0 +1,76 @@
+// UTF-8 validation, code point counting and transcoding to and from
+// UTF-16 and UTF-32.
+//
+// StringPiece and the ascii_* helpers treat text as bytes.  Use these
+// where the bytes come from outside and must be well-formed UTF-8 before
+// they are interpreted:
+//
+//   if (!IsValidUtf8(request.body())) return BadRequest();
+//
+//   std::vector<char16_t> wide(Utf16LengthOfUtf8(text));
+//   Utf8ToUtf16(text, wide.data());
+//
+// Well-formed means what Unicode (Table 3-7) and RFC 3629 say: no
+// overlong forms, no surrogates (U+D800..U+DFFF), nothing above U+10FFFF
+// and no truncated sequences.  UTF-16 must not contain unpaired
+// surrogates, and UTF-32 must hold scalar values only.
+//
+// Validation uses the lookup-table method of Keiser and Lemire
+// ("Validating UTF-8 In Less Than One Instruction Per Byte", 2021): three
+// PSHUFB nibble lookups per block classify every pair of adjacent bytes
+// at once.  It runs 32 bytes per step with AVX2 and 16 with SSSE3, picked
+// at runtime, and skips all-ASCII blocks with a single test.  Counting
+// and the ASCII runs of the transcoders run 16 bytes per step with SSE2.
+// Every path has a scalar fallback that gives the same answers.
+//
+// The transcoders write into caller-provided buffers and never allocate.
+// They do not check the room left: size the output with the *LengthOf*
+// functions, or for the worst case noted on each.
+
+#ifndef FOUNDATION_STRINGS_UTF8_H_
+#define FOUNDATION_STRINGS_UTF8_H_
+
+#include <stddef.h>
+
+#include <foundation/strings/stringpiece.hpp>
+
+namespace foundation {
+
+// True if s is well-formed UTF-8.
+bool IsValidUtf8(StringPiece s);
+
+// The length of the longest well-formed prefix of s: s.size() if s is
+// valid, otherwise the offset of the first byte of the first ill-formed
+// sequence.
+size_t ValidUtf8Prefix(StringPiece s);
+
+// The number of code points in s, which must be valid UTF-8.  (Invalid
+// input gives the number of bytes that are not continuation bytes.)
+size_t CountUtf8CodePoints(StringPiece s);
+
+// Output sizes, in code units, for valid input.
+size_t Utf16LengthOfUtf8(StringPiece s);
+size_t Utf8LengthOfUtf16(const char16_t* s, size_t n);
+size_t Utf8LengthOfUtf32(const char32_t* s, size_t n);
+
+// The outcome of a transcoding call.
+struct TranscodeResult {
+  // False if the input is ill-formed.  read is then the offset of the
+  // first code unit of the first bad sequence, and everything before it
+  // has been converted.
+  bool ok;
+  size_t read;     // Input code units consumed.
+  size_t written;  // Output code units written.
+};
+
+// UTF-8 to UTF-16 and UTF-32.  Either needs at most s.size() output units.
+TranscodeResult Utf8ToUtf16(StringPiece s, char16_t* out);
+TranscodeResult Utf8ToUtf32(StringPiece s, char32_t* out);
+
+// UTF-16 to UTF-8 needs at most 3 * n bytes; UTF-32 at most 4 * n.
+TranscodeResult Utf16ToUtf8(const char16_t* s, size_t n, char* out);
+TranscodeResult Utf32ToUtf8(const char32_t* s, size_t n, char* out);
+
+}  // namespace foundation
+
+#endif  // FOUNDATION_STRINGS_UTF8_H_
@@ -1,9 +1,14 @@
 #ifndef FOUNDATION_STRING_HELPER_HPP__
 #define FOUNDATION_STRING_HELPER_HPP__
 
+#include <foundation/strings/stringpiece.hpp>
+
+#include <string.h>
+
 #include <algorithm>
 #include <iomanip>
 #include <sstream>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
@@ -26,11 +31,46 @@ auto toString( T const& x ) ->decltype(std::to_string(x)) {
 	return std::to_string( x );
 }
 
-inline std::string repeat(unsigned n, std::string const& s) {
-	std::string result = "";
-	for (unsigned i = 0; i < n; ++i) {
-		result += s;
+// Appends n copies of s to *dest.  The output is sized once, the first
+// copy written, and the rest filled by copying what is already there,
+// doubling each time up to 64 KiB per copy, rather than by n appends.  As
+// with StrAppend, s must not point into *dest.  Throws std::length_error,
+// as std::string does, if the result would exceed dest->max_size().
+inline void repeat(std::string* dest, size_t n, StringPiece s) {
+	const size_t length = s.size();
+	if (n == 0 || length == 0) {
+		return;
+	}
+
+	const size_t old_size = dest->size();
+	if (n > (dest->max_size() - old_size) / length) {
+		throw std::length_error("repeat");
+	}
+	const size_t total = n * length;
+	dest->resize(old_size + total);
+	char* const out = &(*dest)[old_size];
+
+	if (length == 1) {
+		memset(out, s[0], total);
+		return;
+	}
+
+	// Double the filled prefix, but cap each copy so that for very large
+	// outputs the source stays cache-resident.  Chunks stay a multiple of
+	// length so every copy lands on a pattern boundary.
+	const size_t kMaxChunk = std::max(length, (size_t(64 * 1024) / length) * length);
+	memcpy(out, s.data(), length);
+	size_t filled = length;
+	while (filled < total) {
+		const size_t chunk = std::min(std::min(filled, kMaxChunk), total - filled);
+		memcpy(out + filled, out, chunk);
+		filled += chunk;
 	}
+}
+
+inline std::string repeat(size_t n, StringPiece s) {
+	std::string result;
+	repeat(&result, n, s);
 	return result;
 }
 
@@ -0,0 +1,86 @@
+#ifndef FOUNDATION_ID_ALLOCATOR_HPP__
+#define FOUNDATION_ID_ALLOCATOR_HPP__
+
+#include <foundation/base/macros.hpp>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+
+namespace foundation {
+
+// ----------------------------------------------------------------------
+// IdAllocator
+//    Hands out 64-bit IDs for internal handles (timers, requests, ...)
+//    without a shared atomic per ID.  Each thread reserves a batch of
+//    batch_size consecutive IDs with one fetch_add on the shared counter
+//    and then serves Next() from that batch out of thread-local storage,
+//    so the counter's cache line is touched once per batch rather than
+//    once per ID.
+//
+//    IDs from one thread are strictly increasing.  Across threads they
+//    are unique but only roughly ordered, and the unused tail of a batch
+//    is lost when its thread exits, so the sequence is dense only up to
+//    batch_size per thread.
+//
+//    An ID can optionally carry fixed high bits: an epoch (e.g. a process
+//    start counter, so IDs survive restarts without colliding) above a
+//    shard (e.g. a host or partition number), with the sequence in the
+//    remaining low bits:
+//
+//      | epoch (epoch_bits) | shard (shard_bits) | sequence |
+//
+//    Next() throws std::overflow_error once the sequence bits run out.
+// ----------------------------------------------------------------------
+class IdAllocator {
+ public:
+  static const uint64_t kDefaultBatchSize = 1024;
+
+  struct Options {
+    Options()
+        : batch_size(kDefaultBatchSize), first(1),
+          epoch_bits(0), epoch(0), shard_bits(0), shard(0) {}
+
+    uint64_t batch_size;  // IDs reserved per refill; at least 1.
+    uint64_t first;       // First sequence number handed out.
+    int epoch_bits;
+    uint64_t epoch;       // Must fit in epoch_bits.
+    int shard_bits;
+    uint64_t shard;       // Must fit in shard_bits.
+  };
+
+  IdAllocator();
+  explicit IdAllocator(const Options& options);
+
+  uint64_t Next();
+
+  // Splits an ID back into its fields.
+  uint64_t EpochOf(uint64_t id) const;
+  uint64_t ShardOf(uint64_t id) const;
+  uint64_t SequenceOf(uint64_t id) const { return id & sequence_mask_; }
+
+  // The process-wide allocator behind getUuid().
+  static IdAllocator* Default();
+
+ private:
+  void Init(const Options& options);
+  uint64_t Refill();
+
+  // Written on every refill; kept apart from the read-mostly fields.
+  alignas(64) std::atomic<uint64_t> next_;
+
+  alignas(64) uint64_t serial_;  // Unique per allocator; keys the TLS cache.
+  uint64_t batch_size_;
+  uint64_t prefix_;              // Epoch and shard bits, pre-shifted.
+  uint64_t sequence_mask_;
+  int epoch_shift_;
+  int shard_shift_;
+  uint64_t shard_mask_;
+
+  DISALLOW_COPY_AND_ASSIGN(IdAllocator);
+};
+
+}  // namespace foundation
+
+#endif  // FOUNDATION_ID_ALLOCATOR_HPP__
@@ -1,8 +1,96 @@
 #ifndef FOUNDATION_UUID_HPP__
 #define FOUNDATION_UUID_HPP__
 
-typedef int uuid;
+#include <foundation/strings/hash.hpp>
+#include <foundation/strings/stringpiece.hpp>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <functional>
+#include <string>
+
+namespace foundation {
+
+// ----------------------------------------------------------------------
+// Uuid
+//    A 128-bit RFC 9562 identifier, held as two 64-bit words in network
+//    byte order (high() holds bytes 0..7 of the canonical form).
+//
+//    GenerateV4() is 122 random bits; GenerateV7() puts a millisecond
+//    Unix timestamp in the top 48 bits so that IDs sort by creation time,
+//    which keeps them friendly to B-tree indexes and logs.
+//
+//    Generation touches only thread-local state: each thread seeds its
+//    own xoshiro256++ generator from std::random_device on first use, so
+//    there is no shared counter or lock.  V7 IDs from one thread are
+//    strictly increasing (a 12-bit counter breaks ties within a
+//    millisecond); IDs from different threads are ordered only to the
+//    millisecond.
+// ----------------------------------------------------------------------
+class Uuid {
+ public:
+  // Length of the canonical text form, e.g.
+  // "0190b7c2-5f3a-7c4e-9a1b-2c3d4e5f6a7b".
+  static const size_t kStringLength = 36;
+
+  // The nil UUID.
+  constexpr Uuid() : high_(0), low_(0) {}
+  constexpr Uuid(uint64_t high, uint64_t low) : high_(high), low_(low) {}
+
+  static Uuid GenerateV4();
+  static Uuid GenerateV7();
+
+  // Parses the canonical 8-4-4-4-12 hex form, in either case.  Returns
+  // false, leaving *out untouched, if text is anything else.
+  static bool Parse(StringPiece text, Uuid* out);
+
+  uint64_t high() const { return high_; }
+  uint64_t low() const { return low_; }
+  int version() const { return static_cast<int>((high_ >> 12) & 0xf); }
+  bool is_nil() const { return (high_ | low_) == 0; }
+
+  // Writes the kStringLength-character lowercase canonical form to out,
+  // without a terminating '\0', and returns out + kStringLength.
+  char* Format(char* out) const;
+  std::string ToString() const;
+
+ private:
+  uint64_t high_;
+  uint64_t low_;
+};
+
+inline bool operator==(Uuid x, Uuid y) {
+  return x.high() == y.high() && x.low() == y.low();
+}
+inline bool operator!=(Uuid x, Uuid y) { return !(x == y); }
+inline bool operator<(Uuid x, Uuid y) {
+  return x.high() < y.high() || (x.high() == y.high() && x.low() < y.low());
+}
+inline bool operator>(Uuid x, Uuid y) { return y < x; }
+inline bool operator<=(Uuid x, Uuid y) { return !(y < x); }
+inline bool operator>=(Uuid x, Uuid y) { return !(x < y); }
+
+}  // namespace foundation
+
+namespace std {
+
+template <>
+struct hash<foundation::Uuid> {
+  size_t operator()(foundation::Uuid u) const {
+    return static_cast<size_t>(foundation::HashCombine(u.high(), u.low()));
+  }
+};
+
+}  // namespace std
+
+// Handles for the timer subsystem and other internal callers that just
+// need a unique value.  Despite the name these are 64-bit IDs from
+// IdAllocator::Default(), not UUIDs: dense, cheap to compare and hash,
+// and never zero.  Use foundation::Uuid for IDs that leave the process.
+// Safe to call from any thread.
+typedef uint64_t uuid;
 
 uuid getUuid();
 
-#endif // FOUNDATION_UUID_HPP__
\ No newline at end of file
+#endif // FOUNDATION_UUID_HPP__
@@ -0,0 +1,121 @@
+
+#include <foundation/base/arena.hpp>
+
+#include <assert.h>
+#include <stdlib.h>
+
+#include <new>
+
+namespace foundation {
+
+Arena::Arena(size_t block_size)
+  : block_size_(block_size),
+    head_(NULL),
+    current_(NULL),
+    large_(NULL),
+    used_in_previous_blocks_(0),
+    used_in_large_blocks_(0),
+    ptr_(NULL),
+    limit_(NULL)
+{}
+
+Arena::~Arena()
+{
+  FreeChain(head_);
+  FreeChain(large_);
+}
+
+Arena::Block* Arena::NewBlock(size_t size)
+{
+  void* memory = malloc(sizeof(Block) + size);
+  if (memory == NULL) {
+    throw std::bad_alloc();
+  }
+  Block* block = static_cast<Block*>(memory);
+  block->next = NULL;
+  block->size = size;
+  return block;
+}
+
+void Arena::FreeChain(Block* block)
+{
+  while (block != NULL) {
+    Block* next = block->next;
+    free(block);
+    block = next;
+  }
+}
+
+void* Arena::AllocateSlow(size_t bytes, size_t alignment)
+{
+  assert((alignment & (alignment - 1)) == 0);
+
+  // Big requests would waste most of a chained block; give them their own.
+  if (bytes + alignment > block_size_ / 4) {
+    Block* block = NewBlock(bytes + alignment);
+    block->next = large_;
+    large_ = block;
+    used_in_large_blocks_ += bytes;
+    const uintptr_t p = reinterpret_cast<uintptr_t>(block->data());
+    return reinterpret_cast<void*>((p + alignment - 1) & ~(alignment - 1));
+  }
+
+  // Move on to the next block in the chain, reusing one left over from
+  // before the last Reset() if there is one.
+  if (current_ != NULL) {
+    used_in_previous_blocks_ += ptr_ - current_->data();
+  }
+  Block* next = (current_ != NULL) ? current_->next : head_;
+  if (next == NULL) {
+    next = NewBlock(block_size_);
+    if (current_ != NULL) {
+      current_->next = next;
+    } else {
+      head_ = next;
+    }
+  }
+  current_ = next;
+  ptr_ = current_->data();
+  limit_ = ptr_ + current_->size;
+
+  const uintptr_t aligned =
+      (reinterpret_cast<uintptr_t>(ptr_) + alignment - 1) & ~(alignment - 1);
+  ptr_ = reinterpret_cast<char*>(aligned + bytes);
+  return reinterpret_cast<void*>(aligned);
+}
+
+void Arena::Reset()
+{
+  FreeChain(large_);
+  large_ = NULL;
+  used_in_large_blocks_ = 0;
+  used_in_previous_blocks_ = 0;
+
+  current_ = head_;
+  if (current_ != NULL) {
+    ptr_ = current_->data();
+    limit_ = ptr_ + current_->size;
+  } else {
+    ptr_ = NULL;
+    limit_ = NULL;
+  }
+}
+
+size_t Arena::bytes_used() const
+{
+  size_t used = used_in_previous_blocks_ + used_in_large_blocks_;
+  if (current_ != NULL) {
+    used += ptr_ - reinterpret_cast<const char*>(current_ + 1);
+  }
+  return used;
+}
+
+size_t Arena::bytes_reserved() const
+{
+  size_t reserved = 0;
+  for (const Block* b = head_; b != NULL; b = b->next) reserved += b->size;
+  for (const Block* b = large_; b != NULL; b = b->next) reserved += b->size;
+  return reserved;
+}
+
+}  // namespace foundation
@@ -0,0 +1,85 @@
+
+#include <foundation/strings/arena_strcat.hpp>
+
+#include <string.h>
+
+namespace foundation {
+
+namespace internal {
+
+StringPiece ArenaCatPieces(Arena* arena,
+                           std::initializer_list<StringPiece> pieces) {
+  size_t total = 0;
+  for (const StringPiece& piece : pieces) {
+    total += piece.size();
+  }
+  char* const begin = arena->AllocateChars(total);
+  char* out = begin;
+  for (const StringPiece& piece : pieces) {
+    if (piece.size() > 0) {
+      memcpy(out, piece.data(), piece.size());
+      out += piece.size();
+    }
+  }
+  return StringPiece(begin, total);
+}
+
+}  // namespace internal
+
+StringPiece ArenaCopy(Arena* arena, StringPiece s) {
+  char* copy = arena->AllocateChars(s.size());
+  if (s.size() > 0) {
+    memcpy(copy, s.data(), s.size());
+  }
+  return StringPiece(copy, s.size());
+}
+
+// Makes room for at least needed more bytes.
+void ArenaStringBuilder::Grow(size_t needed) {
+  const size_t required = size_ + needed;
+  if (required <= capacity_) return;
+
+  // Cheapest case: we are the arena's last allocation and it has room.
+  if (data_ != NULL &&
+      arena_->TryExtend(data_ + capacity_, required - capacity_)) {
+    capacity_ = required;
+    return;
+  }
+
+  size_t capacity = capacity_ < 32 ? 32 : capacity_ * 2;
+  if (capacity < required) capacity = required;
+  char* data = arena_->AllocateChars(capacity);
+  if (size_ > 0) {
+    memcpy(data, data_, size_);
+  }
+  data_ = data;
+  capacity_ = capacity;
+}
+
+void ArenaStringBuilder::AppendPieces(
+    std::initializer_list<StringPiece> pieces) {
+  size_t total = 0;
+  for (const StringPiece& piece : pieces) {
+    total += piece.size();
+  }
+  Grow(total);
+  for (const StringPiece& piece : pieces) {
+    if (piece.size() > 0) {
+      memcpy(data_ + size_, piece.data(), piece.size());
+      size_ += piece.size();
+    }
+  }
+}
+
+StringPiece ArenaStringBuilder::Finish() {
+  const StringPiece result(data_, size_);
+  if (data_ != NULL) {
+    arena_->Rewind(data_ + capacity_, capacity_ - size_);
+  }
+  data_ = NULL;
+  size_ = 0;
+  capacity_ = 0;
+  return result;
+}
+
+}  // namespace foundation
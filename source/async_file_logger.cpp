@@ -0,0 +1,638 @@
+
+#include <foundation/logger/async_file_logger.hpp>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <linux/io_uring.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <system_error>
+
+
+class AsyncFileLogger::Writer
+{
+public:
+  virtual ~Writer() {}
+
+  virtual bool io_uring() const = 0;
+  // How many buffers may be submitted before Reap() returns them.
+  virtual size_t capacity() const = 0;
+
+  // Queues a write of buffer->data[written, size) at the matching offset.
+  virtual void Submit( Buffer* buffer ) = 0;
+
+  // Starts the queued writes and waits for at least one to finish.  Adds
+  // each buffer that is fully written, or has failed, to done; a failure
+  // sets *error to its errno.
+  virtual void Reap( std::vector<Buffer*>* done, int* error ) = 0;
+
+  // True once the writer can no longer write.  Reap() has then returned
+  // every buffer it held.
+  virtual bool failed() const { return false; }
+};
+
+// ----------------------------------------------------------------------
+// io_uring, driven through the raw system calls.
+// ----------------------------------------------------------------------
+class AsyncFileLogger::IoUringWriter : public Writer
+{
+public:
+  // Returns nullptr, with errno set, if the kernel refuses a ring.
+  static IoUringWriter* Create( int fd, std::vector<Buffer>& buffers, size_t bufferSize )
+  {
+    std::unique_ptr<IoUringWriter> writer( new IoUringWriter( fd ) );
+    if ( !writer->Setup( buffers, bufferSize ) )
+    {
+      const int error = errno;
+      writer.reset();
+      errno = error;
+      return nullptr;
+    }
+    return writer.release();
+  }
+
+  ~IoUringWriter()
+  {
+    if ( sqes != MAP_FAILED )
+    {
+      munmap( sqes, sqesSize );
+    }
+    if ( cqRing != MAP_FAILED && cqRing != sqRing )
+    {
+      munmap( cqRing, cqRingSize );
+    }
+    if ( sqRing != MAP_FAILED )
+    {
+      munmap( sqRing, sqRingSize );
+    }
+    if ( ringFd >= 0 )
+    {
+      close( ringFd );
+    }
+  }
+
+  bool io_uring() const { return true; }
+  size_t capacity() const { return entries; }
+  bool failed() const { return broken; }
+
+  void Submit( Buffer* buffer )
+  {
+    outstanding.push_back( buffer );
+    Queue( buffer );
+  }
+
+  void Reap( std::vector<Buffer*>* done, int* error )
+  {
+    // One call submits everything queued and waits for a completion.
+    const int submitted = static_cast<int>( syscall( __NR_io_uring_enter, ringFd, unsubmitted, 1,
+                                                     IORING_ENTER_GETEVENTS, NULL, 0 ) );
+    if ( submitted >= 0 )
+    {
+      unsubmitted -= submitted;
+    }
+    else if ( errno != EINTR && errno != EAGAIN && errno != EBUSY )
+    {
+      *error = errno;
+      broken = true;
+    }
+
+    unsigned head = *cqHead;
+    const unsigned tail = __atomic_load_n( cqTail, __ATOMIC_ACQUIRE );
+    for ( ; head != tail; ++head )
+    {
+      const io_uring_cqe& cqe = cqes[head & cqMask];
+      Buffer* buffer = reinterpret_cast<Buffer*>( cqe.user_data );
+      if ( cqe.res == -EINTR || cqe.res == -EAGAIN )
+      {
+        Queue( buffer );
+      }
+      else if ( cqe.res <= 0 )
+      {
+        *error = cqe.res < 0 ? -cqe.res : EIO;
+        Complete( buffer, done );
+      }
+      else
+      {
+        buffer->written += cqe.res;
+        if ( buffer->written < buffer->size )
+        {
+          Queue( buffer );  //< Short write: send the rest.
+        }
+        else
+        {
+          Complete( buffer, done );
+        }
+      }
+    }
+    __atomic_store_n( cqHead, head, __ATOMIC_RELEASE );
+
+    // A ring that io_uring_enter() keeps refusing would never complete
+    // anything, and waiting on it would hang every writer and Flush().
+    // Give up on it instead: everything still held counts as failed, so
+    // the buffers are recycled, and the logger carries on with pwritev.
+    if ( broken )
+    {
+      done->insert( done->end(), outstanding.begin(), outstanding.end() );
+      outstanding.clear();
+    }
+  }
+
+private:
+  explicit IoUringWriter( int fd )
+    : fd( fd ),
+      ringFd( -1 ),
+      sqRing( MAP_FAILED ),
+      cqRing( MAP_FAILED ),
+      sqes( static_cast<io_uring_sqe*>( MAP_FAILED ) ),
+      fixedBuffers( false ),
+      broken( false ),
+      unsubmitted( 0 )
+  {}
+
+  void Complete( Buffer* buffer, std::vector<Buffer*>* done )
+  {
+    outstanding.erase( std::find( outstanding.begin(), outstanding.end(), buffer ) );
+    done->push_back( buffer );
+  }
+
+  void Queue( Buffer* buffer )
+  {
+    // This thread is the only producer, so the tail needs no atomic load.
+    const unsigned tail = *sqTail;
+    const unsigned index = tail & sqMask;
+    io_uring_sqe* sqe = &sqes[index];
+    memset( sqe, 0, sizeof( *sqe ) );
+    sqe->opcode = fixedBuffers ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>( buffer->data + buffer->written );
+    sqe->len = static_cast<uint32_t>( buffer->size - buffer->written );
+    sqe->off = buffer->offset + buffer->written;
+    sqe->buf_index = static_cast<uint16_t>( buffer->index );
+    sqe->user_data = reinterpret_cast<uint64_t>( buffer );
+    sqArray[index] = index;
+    __atomic_store_n( sqTail, tail + 1, __ATOMIC_RELEASE );
+    ++unsubmitted;
+  }
+
+  bool Setup( std::vector<Buffer>& buffers, size_t bufferSize )
+  {
+    io_uring_params params;
+    memset( &params, 0, sizeof( params ) );
+    ringFd = static_cast<int>( syscall( __NR_io_uring_setup,
+                                        static_cast<unsigned>( buffers.size() ), &params ) );
+    if ( ringFd < 0 )
+    {
+      return false;
+    }
+    entries = params.sq_entries;
+
+    sqRingSize = params.sq_off.array + params.sq_entries * sizeof( unsigned );
+    cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof( io_uring_cqe );
+    const bool singleMmap = ( params.features & IORING_FEAT_SINGLE_MMAP ) != 0;
+    if ( singleMmap )
+    {
+      sqRingSize = cqRingSize = std::max( sqRingSize, cqRingSize );
+    }
+    sqRing = mmap( NULL, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                   ringFd, IORING_OFF_SQ_RING );
+    if ( sqRing == MAP_FAILED )
+    {
+      return false;
+    }
+    cqRing = singleMmap ? sqRing
+                        : mmap( NULL, cqRingSize, PROT_READ | PROT_WRITE,
+                                MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING );
+    if ( cqRing == MAP_FAILED )
+    {
+      return false;
+    }
+    sqesSize = params.sq_entries * sizeof( io_uring_sqe );
+    void* sqesMemory = mmap( NULL, sqesSize, PROT_READ | PROT_WRITE,
+                             MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES );
+    if ( sqesMemory == MAP_FAILED )
+    {
+      return false;
+    }
+    sqes = static_cast<io_uring_sqe*>( sqesMemory );
+
+    char* sq = static_cast<char*>( sqRing );
+    sqTail = reinterpret_cast<unsigned*>( sq + params.sq_off.tail );
+    sqMask = *reinterpret_cast<unsigned*>( sq + params.sq_off.ring_mask );
+    sqArray = reinterpret_cast<unsigned*>( sq + params.sq_off.array );
+    char* cq = static_cast<char*>( cqRing );
+    cqHead = reinterpret_cast<unsigned*>( cq + params.cq_off.head );
+    cqTail = reinterpret_cast<unsigned*>( cq + params.cq_off.tail );
+    cqMask = *reinterpret_cast<unsigned*>( cq + params.cq_off.ring_mask );
+    cqes = reinterpret_cast<io_uring_cqe*>( cq + params.cq_off.cqes );
+
+    // Registered buffers spare the kernel from pinning and unpinning the
+    // pages on every write.  Registration counts against RLIMIT_MEMLOCK
+    // on older kernels; without it, plain writes work just as well.
+    std::vector<iovec> iovecs( buffers.size() );
+    for ( size_t i = 0; i < buffers.size(); ++i )
+    {
+      iovecs[i].iov_base = buffers[i].data;
+      iovecs[i].iov_len = bufferSize;
+    }
+    fixedBuffers = syscall( __NR_io_uring_register, ringFd, IORING_REGISTER_BUFFERS,
+                            iovecs.data(), static_cast<unsigned>( iovecs.size() ) ) == 0;
+    return true;
+  }
+
+  int const fd;
+  int ringFd;
+  unsigned entries;
+
+  void* sqRing;
+  size_t sqRingSize;
+  unsigned* sqTail;
+  unsigned sqMask;
+  unsigned* sqArray;
+
+  void* cqRing;
+  size_t cqRingSize;
+  unsigned* cqHead;
+  unsigned* cqTail;
+  unsigned cqMask;
+  io_uring_cqe* cqes;
+
+  io_uring_sqe* sqes;
+  size_t sqesSize;
+
+  bool fixedBuffers;
+  bool broken;
+  unsigned unsubmitted;
+  std::vector<Buffer*> outstanding;  //< Submitted and not yet reaped.
+};
+
+// ----------------------------------------------------------------------
+// Fallback: the queued buffers go out in one pwritev() per round.
+// ----------------------------------------------------------------------
+class AsyncFileLogger::PwritevWriter : public Writer
+{
+public:
+  PwritevWriter( int fd, size_t buffers )
+    : fd( fd ),
+      buffers( buffers )
+  {}
+
+  bool io_uring() const { return false; }
+  size_t capacity() const { return buffers; }
+
+  void Submit( Buffer* buffer )
+  {
+    queued.push_back( buffer );
+  }
+
+  void Reap( std::vector<Buffer*>* done, int* error )
+  {
+    size_t first = 0;
+    while ( first < queued.size() )
+    {
+      // Gather the run of buffers that continue one another in the file.
+      iovec iov[IOV_MAX];
+      int count = 0;
+      size_t last = first;
+      for ( ; last < queued.size() && count < IOV_MAX; ++last, ++count )
+      {
+        Buffer* buffer = queued[last];
+        if ( last > first && buffer->offset + buffer->written !=
+                             queued[last - 1]->offset + queued[last - 1]->size )
+        {
+          break;
+        }
+        iov[count].iov_base = buffer->data + buffer->written;
+        iov[count].iov_len = buffer->size - buffer->written;
+      }
+
+      Buffer* start = queued[first];
+      ssize_t n = pwritev( fd, iov, count, start->offset + start->written );
+      if ( n < 0 && errno == EINTR )
+      {
+        continue;
+      }
+      if ( n <= 0 )
+      {
+        *error = n < 0 ? errno : EIO;
+        for ( ; first < last; ++first )
+        {
+          done->push_back( queued[first] );
+        }
+        continue;
+      }
+      // Short writes leave the rest of the run for the next pass.
+      while ( n > 0 )
+      {
+        Buffer* buffer = queued[first];
+        const size_t take = std::min<size_t>( n, buffer->size - buffer->written );
+        buffer->written += take;
+        n -= take;
+        if ( buffer->written == buffer->size )
+        {
+          done->push_back( buffer );
+          ++first;
+        }
+      }
+    }
+    queued.clear();
+  }
+
+private:
+  int const fd;
+  size_t const buffers;
+  std::vector<Buffer*> queued;
+};
+
+// ----------------------------------------------------------------------
+// AsyncFileLogger
+// ----------------------------------------------------------------------
+
+AsyncFileLogger::AsyncFileLogger( std::string const& path, Options const& options )
+  : options( options ),
+    fd( -1 ),
+    memory( nullptr ),
+    current( nullptr ),
+    nextOffset( 0 ),
+    acceptedBytes( 0 ),
+    completedBytes( 0 ),
+    droppedLines( 0 ),
+    lastError( 0 ),
+    flushRequested( false ),
+    stopping( false )
+{
+  if ( options.buffer_size == 0 || options.buffer_size > UINT32_MAX || options.buffers < 2 ||
+       options.buffers > SIZE_MAX / options.buffer_size )
+  {
+    throw std::invalid_argument(
+        "AsyncFileLogger: buffer_size must be 1 byte to 4 GiB, buffers at least 2, "
+        "and buffers * buffer_size must fit in size_t" );
+  }
+  if ( options.flush_interval_ms <= 0 )
+  {
+    throw std::invalid_argument( "AsyncFileLogger: flush_interval_ms must be positive" );
+  }
+
+  fd = open( path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644 );
+  if ( fd < 0 )
+  {
+    throw std::system_error( errno, std::generic_category(), path );
+  }
+  const off_t end = lseek( fd, 0, SEEK_END );
+  nextOffset = end > 0 ? static_cast<uint64_t>( end ) : 0;
+
+  void* block = nullptr;
+  if ( posix_memalign( &block, 4096, options.buffers * options.buffer_size ) != 0 )
+  {
+    close( fd );
+    throw std::bad_alloc();
+  }
+  memory = static_cast<char*>( block );
+  buffers.resize( options.buffers );
+  for ( size_t i = 0; i < buffers.size(); ++i )
+  {
+    Buffer& buffer = buffers[i];
+    buffer.data = memory + i * options.buffer_size;
+    buffer.size = 0;
+    buffer.written = 0;
+    buffer.offset = 0;
+    buffer.index = static_cast<int>( i );
+    if ( i > 0 )
+    {
+      freeBuffers.push_back( &buffer );
+    }
+  }
+  current = &buffers[0];
+
+  if ( options.backend != PWRITEV )
+  {
+    writer.reset( IoUringWriter::Create( fd, buffers, options.buffer_size ) );
+    if ( !writer && options.backend == IO_URING )
+    {
+      const int error = errno;
+      free( memory );
+      close( fd );
+      throw std::system_error( error, std::generic_category(), "io_uring_setup" );
+    }
+  }
+  if ( !writer )
+  {
+    writer.reset( new PwritevWriter( fd, buffers.size() ) );
+  }
+
+  thread = std::thread( &AsyncFileLogger::Run, this );
+}
+
+AsyncFileLogger::~AsyncFileLogger()
+{
+  {
+    std::lock_guard<std::mutex> lock( mutex );
+    stopping = true;
+  }
+  readyToWrite.notify_one();
+  thread.join();
+  writer.reset();
+  free( memory );
+  close( fd );
+}
+
+void AsyncFileLogger::write( std::string const& line )
+{
+  Append( line.data(), line.size() );
+}
+
+void AsyncFileLogger::Append( char const* data, size_t size )
+{
+  std::unique_lock<std::mutex> lock( mutex );
+
+  // Wait for room for the whole line up front, so that it is copied in
+  // one go and no other line can land in the middle of it.  Only a line
+  // too long to ever fit is copied piecemeal, waiting as it goes.
+  auto fits = [this, size] {
+    return size <= options.buffer_size - current->size +
+                   freeBuffers.size() * options.buffer_size;
+  };
+  if ( !fits() )
+  {
+    if ( options.drop_when_full )
+    {
+      ++droppedLines;
+      return;
+    }
+    if ( size <= buffers.size() * options.buffer_size )
+    {
+      recycled.wait( lock, fits );
+    }
+  }
+
+  while ( size > 0 )
+  {
+    const size_t room = options.buffer_size - current->size;
+    if ( room == 0 )
+    {
+      if ( !Rotate( lock ) )
+      {
+        ++droppedLines;
+        return;
+      }
+      continue;
+    }
+    const size_t take = std::min( room, size );
+    memcpy( current->data + current->size, data, take );
+    current->size += take;
+    acceptedBytes += take;
+    data += take;
+    size -= take;
+  }
+}
+
+// Makes room for more data, waiting for a buffer to be recycled if need
+// be.  Returns false, without waiting, if none is free and the logger
+// drops instead.
+bool AsyncFileLogger::Rotate( std::unique_lock<std::mutex>& lock )
+{
+  if ( freeBuffers.empty() )
+  {
+    if ( options.drop_when_full )
+    {
+      return false;
+    }
+    // The writer may rotate in the meantime, so the caller re-checks.
+    recycled.wait( lock, [this] { return !freeBuffers.empty(); } );
+    return true;
+  }
+  SwapCurrent();
+  return true;
+}
+
+// Seals the current buffer for the writer and starts a free one.
+// Requires the lock, a non-empty current buffer and a free buffer.
+void AsyncFileLogger::SwapCurrent()
+{
+  current->offset = nextOffset;
+  nextOffset += current->size;
+  sealed.push_back( current );
+  current = freeBuffers.back();
+  freeBuffers.pop_back();
+  readyToWrite.notify_one();
+}
+
+void AsyncFileLogger::Run()
+{
+  const std::chrono::milliseconds interval( options.flush_interval_ms );
+  std::deque<Buffer*> pending;  //< Sealed, waiting for room in the writer.
+  std::vector<Buffer*> done;
+  size_t inFlight = 0;
+
+  for ( ;; )
+  {
+    {
+      std::unique_lock<std::mutex> lock( mutex );
+      bool timedOut = false;
+      if ( inFlight == 0 && pending.empty() && sealed.empty() )
+      {
+        timedOut = !readyToWrite.wait_for( lock, interval, [this] {
+          return !sealed.empty() || flushRequested || stopping;
+        } );
+      }
+      // Write out a partly filled buffer when idle, or when asked to.
+      if ( timedOut || flushRequested || stopping )
+      {
+        if ( current->size == 0 )
+        {
+          flushRequested = false;
+        }
+        else if ( !freeBuffers.empty() )
+        {
+          SwapCurrent();
+          flushRequested = false;
+        }
+      }
+      if ( stopping && inFlight == 0 && pending.empty() && sealed.empty() &&
+           current->size == 0 )
+      {
+        break;
+      }
+      pending.insert( pending.end(), sealed.begin(), sealed.end() );
+      sealed.clear();
+    }
+
+    while ( inFlight < writer->capacity() && !pending.empty() )
+    {
+      writer->Submit( pending.front() );
+      pending.pop_front();
+      ++inFlight;
+    }
+    if ( inFlight == 0 )
+    {
+      continue;
+    }
+
+    done.clear();
+    int error = 0;
+    writer->Reap( &done, &error );
+    inFlight -= done.size();
+    if ( done.empty() && error == 0 )
+    {
+      continue;
+    }
+
+    std::lock_guard<std::mutex> lock( mutex );
+    if ( writer->failed() )
+    {
+      writer.reset( new PwritevWriter( fd, buffers.size() ) );
+    }
+    for ( Buffer* buffer : done )
+    {
+      completedBytes += buffer->size;
+      buffer->size = 0;
+      buffer->written = 0;
+      freeBuffers.push_back( buffer );
+    }
+    if ( error != 0 )
+    {
+      lastError = error;
+    }
+    recycled.notify_all();
+    flushed.notify_all();
+  }
+}
+
+void AsyncFileLogger::Flush()
+{
+  std::unique_lock<std::mutex> lock( mutex );
+  const uint64_t target = acceptedBytes;
+  if ( completedBytes >= target )
+  {
+    return;
+  }
+  flushRequested = true;
+  readyToWrite.notify_one();
+  flushed.wait( lock, [this, target] { return completedBytes >= target; } );
+}
+
+bool AsyncFileLogger::using_io_uring() const
+{
+  std::lock_guard<std::mutex> lock( mutex );  //< Run() may replace writer.
+  return writer->io_uring();
+}
+
+uint64_t AsyncFileLogger::dropped() const
+{
+  std::lock_guard<std::mutex> lock( mutex );
+  return droppedLines;
+}
+
+int AsyncFileLogger::error() const
+{
+  std::lock_guard<std::mutex> lock( mutex );
+  return lastError;
+}
@@ -0,0 +1,853 @@
+#include <foundation/strings/escaping.hpp>
+#include <foundation/strings/charset.hpp>
+#include <foundation/strings/utf8.hpp>
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define ESCAPING_HAVE_X86_SIMD 1
+#endif
+
+namespace foundation {
+
+namespace {
+
+const char kHexDigits[] = "0123456789abcdef";
+
+inline int HexDigitValue(unsigned char c) {
+  if (static_cast<unsigned>(c - '0') < 10) return c - '0';
+  c |= 0x20;
+  if (static_cast<unsigned>(c - 'a') < 6) return c - 'a' + 10;
+  return -1;
+}
+
+inline bool Fail(size_t offset, size_t* error_offset) {
+  if (error_offset != NULL) *error_offset = offset;
+  return false;
+}
+
+// ----------------------------------------------------------------------
+// Hex
+//
+// 16 bytes per step with SSE2.  Encoding splits each byte into nibbles,
+// turns them into digits with a compare and an add, and interleaves the
+// high and low digits.  Decoding does the reverse on 32 characters, and
+// hands a block containing anything but hex digits to the scalar loop,
+// which finds the exact offset.
+// ----------------------------------------------------------------------
+
+#if defined(__SSE2__)
+
+inline __m128i Load16(const char* p) {
+  return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+}
+
+// 0xFF in each byte of v in [lo, lo + n).  See ascii_ctype.cpp.
+inline __m128i InRange(__m128i v, char lo, int n) {
+  const __m128i biased = _mm_add_epi8(v, _mm_set1_epi8(static_cast<char>(
+                                             -128 - static_cast<int>(lo))));
+  return _mm_cmplt_epi8(biased, _mm_set1_epi8(static_cast<char>(-128 + n)));
+}
+
+inline __m128i NibblesToHex(__m128i nibbles) {
+  const __m128i letter = _mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9));
+  return _mm_add_epi8(_mm_add_epi8(nibbles, _mm_set1_epi8('0')),
+                      _mm_and_si128(letter, _mm_set1_epi8('a' - '0' - 10)));
+}
+
+// The values of the 16 hex digits in v.  Returns false if any byte is
+// not a hex digit.
+inline bool HexToNibbles(__m128i v, __m128i* nibbles) {
+  const __m128i is_digit = InRange(v, '0', 10);
+  const __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+  const __m128i is_letter = InRange(lower, 'a', 6);
+  if (_mm_movemask_epi8(_mm_or_si128(is_digit, is_letter)) != 0xFFFF) {
+    return false;
+  }
+  *nibbles = _mm_or_si128(
+      _mm_and_si128(is_digit, _mm_sub_epi8(v, _mm_set1_epi8('0'))),
+      _mm_and_si128(is_letter,
+                    _mm_sub_epi8(lower, _mm_set1_epi8('a' - 10))));
+  return true;
+}
+
+// Joins pairs of nibbles (high first) into 8 bytes, in the low half.
+inline __m128i JoinNibblePairs(__m128i nibbles) {
+  return _mm_or_si128(
+      _mm_and_si128(_mm_slli_epi16(nibbles, 4), _mm_set1_epi16(0xF0)),
+      _mm_srli_epi16(nibbles, 8));
+}
+
+#endif  // __SSE2__
+
+// ----------------------------------------------------------------------
+// Base64
+//
+// The vector kernels follow Muła and Lemire, "Faster Base64 Encoding and
+// Decoding Using AVX2 Instructions" (2018).
+//
+// Encoding shuffles each 3 input bytes into a 32-bit lane, isolates the
+// four 6-bit fields with two multiplies, and maps each field to its
+// character by adding an offset that PSHUFB looks up from the field's
+// range.
+//
+// Decoding classifies each character by its low nibble (which high
+// nibbles are valid with it) and its high nibble (the offset that maps
+// it to its value).  The one character whose offset differs from the
+// rest of its high nibble is patched separately.  Two multiply-adds
+// pack 4 values into 3 bytes.
+//
+// The vector loops only take whole blocks that are all alphabet
+// characters.  Padding, errors and the tail are left to the scalar loop,
+// which works in 4-character quads, so it can resume at any block
+// boundary.
+// ----------------------------------------------------------------------
+
+const uint8_t kNotInAlphabet = 0xFF;
+
+struct Base64Alphabet {
+  constexpr Base64Alphabet(const char* chars, bool padded)
+      : encode{},
+        decode{},
+        encode_offset{},
+        decode_offset{},
+        decode_mask{},
+        decode_special(chars[63]),
+        decode_special_offset(static_cast<int8_t>(63 - chars[63])),
+        padded(padded) {
+    for (int c = 0; c < 256; ++c) {
+      decode[c] = kNotInAlphabet;
+    }
+    for (int value = 0; value < 64; ++value) {
+      const unsigned char c = static_cast<unsigned char>(chars[value]);
+      encode[value] = chars[value];
+      decode[c] = static_cast<uint8_t>(value);
+      decode_mask[c & 0x0F] |= static_cast<int8_t>(1 << (c >> 4));
+      if (value < 63) {
+        decode_offset[c >> 4] = static_cast<int8_t>(value - c);
+      }
+    }
+    // Indexed by the output of the range reduction in EncodeLookupSsse3().
+    encode_offset[0] = 'a' - 26;
+    for (int i = 1; i <= 10; ++i) {
+      encode_offset[i] = '0' - 52;
+    }
+    encode_offset[11] = static_cast<int8_t>(chars[62] - 62);
+    encode_offset[12] = static_cast<int8_t>(chars[63] - 63);
+    encode_offset[13] = 'A';
+  }
+
+  char encode[64];
+  uint8_t decode[256];  // Value of each character, or kNotInAlphabet.
+
+  // Tables for the vector kernels.
+  int8_t encode_offset[16];
+  int8_t decode_offset[16];  // By high nibble.
+  int8_t decode_mask[16];    // By low nibble: bit h for each valid high nibble.
+  char decode_special;       // The character that does not fit decode_offset.
+  int8_t decode_special_offset;
+
+  // Encoding pads, and decoding requires it.
+  bool padded;
+};
+
+constexpr Base64Alphabet kStandard(
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/", true);
+constexpr Base64Alphabet kUrlSafe(
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_", false);
+
+size_t Base64EncodeScalar(const Base64Alphabet& alphabet,
+                          const unsigned char* p, size_t n, char* out) {
+  const char* const chars = alphabet.encode;
+  char* w = out;
+  size_t i = 0;
+  for (; i + 3 <= n; i += 3) {
+    const uint32_t v = (uint32_t(p[i]) << 16) | (uint32_t(p[i + 1]) << 8) |
+                       p[i + 2];
+    w[0] = chars[v >> 18];
+    w[1] = chars[(v >> 12) & 0x3F];
+    w[2] = chars[(v >> 6) & 0x3F];
+    w[3] = chars[v & 0x3F];
+    w += 4;
+  }
+  if (i + 1 == n) {
+    const uint32_t v = uint32_t(p[i]) << 16;
+    *w++ = chars[v >> 18];
+    *w++ = chars[(v >> 12) & 0x3F];
+    if (alphabet.padded) {
+      *w++ = '=';
+      *w++ = '=';
+    }
+  } else if (i + 2 == n) {
+    const uint32_t v = (uint32_t(p[i]) << 16) | (uint32_t(p[i + 1]) << 8);
+    *w++ = chars[v >> 18];
+    *w++ = chars[(v >> 12) & 0x3F];
+    *w++ = chars[(v >> 6) & 0x3F];
+    if (alphabet.padded) *w++ = '=';
+  }
+  return w - out;
+}
+
+// Decodes p[i, n), where i is a multiple of 4, appending to out[*w].
+bool Base64DecodeScalar(const Base64Alphabet& alphabet, const char* src,
+                        size_t n, size_t i, char* out, size_t* w,
+                        size_t* error_offset) {
+  const unsigned char* const p = reinterpret_cast<const unsigned char*>(src);
+  const uint8_t* const decode = alphabet.decode;
+  char* o = out + *w;
+  for (; i + 4 <= n; i += 4) {
+    const uint32_t a = decode[p[i]], b = decode[p[i + 1]],
+                   c = decode[p[i + 2]], d = decode[p[i + 3]];
+    if ((a | b | c | d) >= 64) break;  // Padding, an error, or both.
+    const uint32_t v = (a << 18) | (b << 12) | (c << 6) | d;
+    o[0] = static_cast<char>(v >> 16);
+    o[1] = static_cast<char>(v >> 8);
+    o[2] = static_cast<char>(v);
+    o += 3;
+  }
+  *w = o - out;
+  if (i == n) return true;
+
+  // A final group of k < 4 characters, then padding or the end.
+  size_t k = 0;
+  while (i + k < n && k < 4 && decode[p[i + k]] < 64) ++k;
+  if (i + k < n) {
+    // Only padding may follow, completing the quad and the input.
+    if (k < 2 || p[i + k] != '=') return Fail(i + k, error_offset);
+    for (size_t j = k + 1; j < 4; ++j) {
+      if (i + j == n) return Fail(n, error_offset);
+      if (p[i + j] != '=') return Fail(i + j, error_offset);
+    }
+    if (i + 4 != n) return Fail(i + 4, error_offset);
+  } else if (k < 2 || alphabet.padded) {
+    return Fail(n, error_offset);
+  }
+
+  // The bits past the last whole byte must be zero.
+  const uint32_t a = decode[p[i]], b = decode[p[i + 1]];
+  *o++ = static_cast<char>((a << 2) | (b >> 4));
+  if (k == 2) {
+    if ((b & 0x0F) != 0) return Fail(i + 1, error_offset);
+  } else {
+    const uint32_t c = decode[p[i + 2]];
+    if ((c & 0x03) != 0) return Fail(i + 2, error_offset);
+    *o++ = static_cast<char>((b << 4) | (c >> 2));
+  }
+  *w = o - out;
+  return true;
+}
+
+typedef size_t (*Base64EncodeFn)(const Base64Alphabet& alphabet,
+                                 const unsigned char* p, size_t n, char* out);
+// Decodes as many whole blocks as it can from the start of src, and
+// returns the number of characters consumed (a multiple of 4).
+typedef size_t (*Base64DecodeBlocksFn)(const Base64Alphabet& alphabet,
+                                       const char* src, size_t n, char* out,
+                                       size_t* written);
+
+size_t Base64DecodeBlocksScalar(const Base64Alphabet&, const char*, size_t,
+                                char*, size_t* written) {
+  *written = 0;
+  return 0;
+}
+
+#ifdef ESCAPING_HAVE_X86_SIMD
+
+__attribute__((target("ssse3")))
+inline __m128i LoadTable16(const int8_t* table) {
+  return _mm_loadu_si128(reinterpret_cast<const __m128i*>(table));
+}
+
+// Spreads bytes 0..11 of in over four 32-bit lanes of 6-bit fields.
+__attribute__((target("ssse3")))
+inline __m128i SplitSextetsSsse3(__m128i in) {
+  in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7,
+                                         4, 5, 3, 4, 1, 2, 0, 1));
+  const __m128i ac = _mm_mulhi_epu16(
+      _mm_and_si128(in, _mm_set1_epi32(0x0FC0FC00)),
+      _mm_set1_epi32(0x04000040));
+  const __m128i bd = _mm_mullo_epi16(
+      _mm_and_si128(in, _mm_set1_epi32(0x003F03F0)),
+      _mm_set1_epi32(0x01000010));
+  return _mm_or_si128(ac, bd);
+}
+
+// Maps 6-bit values to characters.  The range reduction sends 0..25 to
+// 13, 26..51 to 0, 52..61 to 1..10, 62 to 11 and 63 to 12.
+__attribute__((target("ssse3")))
+inline __m128i EncodeLookupSsse3(__m128i sextets, __m128i offsets) {
+  __m128i index = _mm_subs_epu8(sextets, _mm_set1_epi8(51));
+  const __m128i upper = _mm_cmpgt_epi8(_mm_set1_epi8(26), sextets);
+  index = _mm_or_si128(index, _mm_and_si128(upper, _mm_set1_epi8(13)));
+  return _mm_add_epi8(sextets, _mm_shuffle_epi8(offsets, index));
+}
+
+__attribute__((target("ssse3")))
+size_t Base64EncodeSsse3(const Base64Alphabet& alphabet,
+                         const unsigned char* p, size_t n, char* out) {
+  const __m128i offsets = LoadTable16(alphabet.encode_offset);
+  size_t i = 0;
+  char* w = out;
+  // Each step reads 16 bytes and uses 12.
+  for (; i + 16 <= n; i += 12, w += 16) {
+    const __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(w),
+                     EncodeLookupSsse3(SplitSextetsSsse3(in), offsets));
+  }
+  return (w - out) + Base64EncodeScalar(alphabet, p + i, n - i, w);
+}
+
+// The values of the 16 characters in, or false if any is not in the
+// alphabet.
+__attribute__((target("ssse3")))
+inline bool DecodeLookupSsse3(const Base64Alphabet& alphabet, __m128i in,
+                              __m128i* values) {
+  const __m128i nibble = _mm_set1_epi8(0x0F);
+  const __m128i high = _mm_and_si128(_mm_srli_epi32(in, 4), nibble);
+  const __m128i low = _mm_and_si128(in, nibble);
+  // PSHUFB gives 0 for high nibbles 8..15, which rejects bytes >= 0x80.
+  const __m128i bit_for_high_nibble =
+      _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 0, 0, 0, 0, 0, 0, 0, 0);
+  const __m128i valid_bits =
+      _mm_and_si128(_mm_shuffle_epi8(LoadTable16(alphabet.decode_mask), low),
+                    _mm_shuffle_epi8(bit_for_high_nibble, high));
+  if (_mm_movemask_epi8(_mm_cmpeq_epi8(valid_bits, _mm_setzero_si128())) !=
+      0) {
+    return false;
+  }
+  const __m128i special =
+      _mm_cmpeq_epi8(in, _mm_set1_epi8(alphabet.decode_special));
+  const __m128i offset = _mm_or_si128(
+      _mm_andnot_si128(special,
+                       _mm_shuffle_epi8(LoadTable16(alphabet.decode_offset),
+                                        high)),
+      _mm_and_si128(special, _mm_set1_epi8(alphabet.decode_special_offset)));
+  *values = _mm_add_epi8(in, offset);
+  return true;
+}
+
+// Packs 16 values into 12 bytes, at the bottom of the result.
+__attribute__((target("ssse3")))
+inline __m128i PackSextetsSsse3(__m128i values) {
+  const __m128i pairs =
+      _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+  const __m128i quads = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+  return _mm_shuffle_epi8(quads, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8,
+                                               14, 13, 12, -1, -1, -1, -1));
+}
+
+__attribute__((target("ssse3")))
+size_t Base64DecodeBlocksSsse3(const Base64Alphabet& alphabet,
+                               const char* src, size_t n, char* out,
+                               size_t* written) {
+  size_t i = 0;
+  size_t w = 0;
+  // Each step stores 16 bytes of which 12 are output.  Leaving at least 8
+  // characters (4 more output bytes) unread keeps the spare 4 in bounds.
+  for (; i + 24 <= n; i += 16, w += 12) {
+    __m128i values;
+    const __m128i in =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    if (!DecodeLookupSsse3(alphabet, in, &values)) break;
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + w),
+                     PackSextetsSsse3(values));
+  }
+  *written = w;
+  return i;
+}
+
+__attribute__((target("avx2")))
+inline __m256i LoadTable32(const int8_t* table) {
+  return _mm256_broadcastsi128_si256(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(table)));
+}
+
+__attribute__((target("avx2")))
+size_t Base64EncodeAvx2(const Base64Alphabet& alphabet,
+                        const unsigned char* p, size_t n, char* out) {
+  const __m256i offsets = LoadTable32(alphabet.encode_offset);
+  const __m256i shuffle = _mm256_setr_epi8(
+      1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+      1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+  size_t i = 0;
+  char* w = out;
+  // Each lane takes 12 bytes, so the two 16-byte loads overlap.
+  for (; i + 28 <= n; i += 24, w += 32) {
+    __m256i in = _mm256_inserti128_si256(
+        _mm256_castsi128_si256(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i))),
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i + 12)), 1);
+    in = _mm256_shuffle_epi8(in, shuffle);
+    const __m256i sextets = _mm256_or_si256(
+        _mm256_mulhi_epu16(_mm256_and_si256(in, _mm256_set1_epi32(0x0FC0FC00)),
+                           _mm256_set1_epi32(0x04000040)),
+        _mm256_mullo_epi16(_mm256_and_si256(in, _mm256_set1_epi32(0x003F03F0)),
+                           _mm256_set1_epi32(0x01000010)));
+    __m256i index = _mm256_subs_epu8(sextets, _mm256_set1_epi8(51));
+    const __m256i upper = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), sextets);
+    index = _mm256_or_si256(index,
+                            _mm256_and_si256(upper, _mm256_set1_epi8(13)));
+    _mm256_storeu_si256(
+        reinterpret_cast<__m256i*>(w),
+        _mm256_add_epi8(sextets, _mm256_shuffle_epi8(offsets, index)));
+  }
+  return (w - out) + Base64EncodeSsse3(alphabet, p + i, n - i, w);
+}
+
+__attribute__((target("avx2")))
+size_t Base64DecodeBlocksAvx2(const Base64Alphabet& alphabet,
+                              const char* src, size_t n, char* out,
+                              size_t* written) {
+  const __m256i nibble = _mm256_set1_epi8(0x0F);
+  const __m256i bit_for_high_nibble = _mm256_setr_epi8(
+      1, 2, 4, 8, 16, 32, 64, -128, 0, 0, 0, 0, 0, 0, 0, 0,
+      1, 2, 4, 8, 16, 32, 64, -128, 0, 0, 0, 0, 0, 0, 0, 0);
+  const __m256i masks = LoadTable32(alphabet.decode_mask);
+  const __m256i offsets = LoadTable32(alphabet.decode_offset);
+  const __m256i special_char = _mm256_set1_epi8(alphabet.decode_special);
+  const __m256i special_offset =
+      _mm256_set1_epi8(alphabet.decode_special_offset);
+  const __m256i pack = _mm256_setr_epi8(
+      2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+      2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+  size_t i = 0;
+  size_t w = 0;
+  // 32 characters make 24 bytes; the store writes 32, so keep 16
+  // characters (at least 10 more bytes) unread.
+  for (; i + 48 <= n; i += 32, w += 24) {
+    const __m256i in =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+    const __m256i high = _mm256_and_si256(_mm256_srli_epi32(in, 4), nibble);
+    const __m256i valid_bits = _mm256_and_si256(
+        _mm256_shuffle_epi8(masks, _mm256_and_si256(in, nibble)),
+        _mm256_shuffle_epi8(bit_for_high_nibble, high));
+    if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(
+            valid_bits, _mm256_setzero_si256())) != 0) {
+      break;
+    }
+    const __m256i special = _mm256_cmpeq_epi8(in, special_char);
+    const __m256i values = _mm256_add_epi8(
+        in, _mm256_blendv_epi8(_mm256_shuffle_epi8(offsets, high),
+                               special_offset, special));
+    const __m256i pairs =
+        _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140));
+    const __m256i quads =
+        _mm256_madd_epi16(pairs, _mm256_set1_epi32(0x00011000));
+    // 12 bytes at the bottom of each lane; close the gap between them.
+    const __m256i packed = _mm256_permutevar8x32_epi32(
+        _mm256_shuffle_epi8(quads, pack),
+        _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + w), packed);
+  }
+  size_t rest = 0;
+  i += Base64DecodeBlocksSsse3(alphabet, src + i, n - i, out + w, &rest);
+  *written = w + rest;
+  return i;
+}
+
+#endif  // ESCAPING_HAVE_X86_SIMD
+
+struct Base64Kernels {
+  Base64EncodeFn encode;
+  Base64DecodeBlocksFn decode_blocks;
+};
+
+Base64Kernels ResolveBase64Kernels() {
+  Base64Kernels kernels = {Base64EncodeScalar, Base64DecodeBlocksScalar};
+#ifdef ESCAPING_HAVE_X86_SIMD
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    kernels.encode = Base64EncodeAvx2;
+    kernels.decode_blocks = Base64DecodeBlocksAvx2;
+  } else if (__builtin_cpu_supports("ssse3")) {
+    kernels.encode = Base64EncodeSsse3;
+    kernels.decode_blocks = Base64DecodeBlocksSsse3;
+  }
+#endif
+  return kernels;
+}
+
+inline const Base64Kernels& GetBase64Kernels() {
+  static const Base64Kernels kernels = ResolveBase64Kernels();
+  return kernels;
+}
+
+StringPiece Base64EncodeWith(const Base64Alphabet& alphabet, StringPiece src,
+                             char* out) {
+  const size_t size = GetBase64Kernels().encode(
+      alphabet, reinterpret_cast<const unsigned char*>(src.data()),
+      src.size(), out);
+  return StringPiece(out, size);
+}
+
+bool Base64DecodeWith(const Base64Alphabet& alphabet, StringPiece src,
+                      char* out, StringPiece* decoded, size_t* error_offset) {
+  size_t written = 0;
+  const size_t consumed = GetBase64Kernels().decode_blocks(
+      alphabet, src.data(), src.size(), out, &written);
+  if (!Base64DecodeScalar(alphabet, src.data(), src.size(), consumed, out,
+                          &written, error_offset)) {
+    return false;
+  }
+  *decoded = StringPiece(out, written);
+  return true;
+}
+
+StringPiece ArenaEncode(Arena* arena, StringPiece src, size_t size,
+                        StringPiece (*encode)(StringPiece, char*)) {
+  return encode(src, arena->AllocateChars(size));
+}
+
+// Decodes into the largest output src could need, then hands back to the
+// arena what was not used (all of it, on failure).
+bool ArenaDecode(Arena* arena, StringPiece src, size_t max_size,
+                 bool (*decode)(StringPiece, char*, StringPiece*, size_t*),
+                 StringPiece* decoded, size_t* error_offset) {
+  char* const out = arena->AllocateChars(max_size);
+  StringPiece result;
+  const bool ok = decode(src, out, &result, error_offset);
+  arena->Rewind(out + max_size, max_size - (ok ? result.size() : 0));
+  if (ok) *decoded = result;
+  return ok;
+}
+
+}  // namespace
+
+StringPiece HexEncode(StringPiece src, char* out) {
+  const unsigned char* const p =
+      reinterpret_cast<const unsigned char*>(src.data());
+  const size_t n = src.size();
+  size_t i = 0;
+#if defined(__SSE2__)
+  const __m128i nibble = _mm_set1_epi8(0x0F);
+  for (; i + 16 <= n; i += 16) {
+    const __m128i in = Load16(src.data() + i);
+    const __m128i high =
+        NibblesToHex(_mm_and_si128(_mm_srli_epi16(in, 4), nibble));
+    const __m128i low = NibblesToHex(_mm_and_si128(in, nibble));
+    __m128i* const dst = reinterpret_cast<__m128i*>(out + 2 * i);
+    _mm_storeu_si128(dst, _mm_unpacklo_epi8(high, low));
+    _mm_storeu_si128(dst + 1, _mm_unpackhi_epi8(high, low));
+  }
+#endif
+  for (; i < n; ++i) {
+    out[2 * i] = kHexDigits[p[i] >> 4];
+    out[2 * i + 1] = kHexDigits[p[i] & 0x0F];
+  }
+  return StringPiece(out, 2 * n);
+}
+
+StringPiece HexEncode(Arena* arena, StringPiece src) {
+  return ArenaEncode(arena, src, HexEncodedSize(src.size()), HexEncode);
+}
+
+bool HexDecode(StringPiece src, char* out, StringPiece* decoded,
+               size_t* error_offset) {
+  const char* const p = src.data();
+  const size_t n = src.size();
+  size_t i = 0;
+#if defined(__SSE2__)
+  for (; i + 32 <= n; i += 32) {
+    __m128i a, b;
+    if (!HexToNibbles(Load16(p + i), &a) ||
+        !HexToNibbles(Load16(p + i + 16), &b)) {
+      break;
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i / 2),
+                     _mm_packus_epi16(JoinNibblePairs(a), JoinNibblePairs(b)));
+  }
+#endif
+  for (; i + 2 <= n; i += 2) {
+    const int high = HexDigitValue(p[i]);
+    if (high < 0) return Fail(i, error_offset);
+    const int low = HexDigitValue(p[i + 1]);
+    if (low < 0) return Fail(i + 1, error_offset);
+    out[i / 2] = static_cast<char>((high << 4) | low);
+  }
+  if (i != n) {
+    // An odd length: blame the last character if it is bad anyway.
+    return Fail(HexDigitValue(p[i]) < 0 ? i : n, error_offset);
+  }
+  *decoded = StringPiece(out, n / 2);
+  return true;
+}
+
+bool HexDecode(Arena* arena, StringPiece src, StringPiece* decoded,
+               size_t* error_offset) {
+  return ArenaDecode(arena, src, HexDecodedMaxSize(src.size()), HexDecode,
+                     decoded, error_offset);
+}
+
+StringPiece Base64Encode(StringPiece src, char* out) {
+  return Base64EncodeWith(kStandard, src, out);
+}
+
+StringPiece Base64Encode(Arena* arena, StringPiece src) {
+  return ArenaEncode(arena, src, Base64EncodedSize(src.size()), Base64Encode);
+}
+
+StringPiece Base64UrlEncode(StringPiece src, char* out) {
+  return Base64EncodeWith(kUrlSafe, src, out);
+}
+
+StringPiece Base64UrlEncode(Arena* arena, StringPiece src) {
+  return ArenaEncode(arena, src, Base64UrlEncodedSize(src.size()),
+                     Base64UrlEncode);
+}
+
+bool Base64Decode(StringPiece src, char* out, StringPiece* decoded,
+                  size_t* error_offset) {
+  return Base64DecodeWith(kStandard, src, out, decoded, error_offset);
+}
+
+bool Base64Decode(Arena* arena, StringPiece src, StringPiece* decoded,
+                  size_t* error_offset) {
+  return ArenaDecode(arena, src, Base64DecodedMaxSize(src.size()),
+                     Base64Decode, decoded, error_offset);
+}
+
+bool Base64UrlDecode(StringPiece src, char* out, StringPiece* decoded,
+                     size_t* error_offset) {
+  return Base64DecodeWith(kUrlSafe, src, out, decoded, error_offset);
+}
+
+bool Base64UrlDecode(Arena* arena, StringPiece src, StringPiece* decoded,
+                     size_t* error_offset) {
+  return ArenaDecode(arena, src, Base64DecodedMaxSize(src.size()),
+                     Base64UrlDecode, decoded, error_offset);
+}
+
+
+// ----------------------------------------------------------------------
+// C and JSON escaping
+//
+// The escapers find the next byte that needs escaping with a CharSet
+// scan, which StringPiece runs 16 or 32 bytes per step (SSSE3 or AVX2),
+// append the clean run before it in one go, then escape the byte.  The
+// unescapers do the same with the bytes that start an escape (or are
+// not allowed raw).
+// ----------------------------------------------------------------------
+
+namespace {
+
+constexpr CharSet kCSpecial = ~CharSet::Range(0x20, 0x7E) | CharSet("\"'\\");
+constexpr CharSet kJsonSpecial = CharSet::Range(0x00, 0x1F) | CharSet("\"\\");
+
+// Appends src, calling escape(c, dest) for each byte in special.
+template <typename EscapeFn>
+void EscapeAndAppend(StringPiece src, const CharSet& special, string* dest,
+                     EscapeFn escape) {
+  dest->reserve(dest->size() + src.size());
+  size_t pos = 0;
+  for (;;) {
+    const stringpiece_ssize_type hit = src.find_first_of(special, pos);
+    if (hit < 0) {
+      dest->append(src.data() + pos, src.size() - pos);
+      return;
+    }
+    dest->append(src.data() + pos, hit - pos);
+    escape(static_cast<unsigned char>(src[hit]), dest);
+    pos = hit + 1;
+  }
+}
+
+void AppendCEscaped(unsigned char c, string* dest) {
+  switch (c) {
+    case '\n': dest->append("\\n", 2); return;
+    case '\r': dest->append("\\r", 2); return;
+    case '\t': dest->append("\\t", 2); return;
+    case '\"': dest->append("\\\"", 2); return;
+    case '\'': dest->append("\\'", 2); return;
+    case '\\': dest->append("\\\\", 2); return;
+  }
+  const char octal[4] = {'\\', static_cast<char>('0' + (c >> 6)),
+                         static_cast<char>('0' + ((c >> 3) & 7)),
+                         static_cast<char>('0' + (c & 7))};
+  dest->append(octal, 4);
+}
+
+void AppendJsonEscaped(unsigned char c, string* dest) {
+  switch (c) {
+    case '\b': dest->append("\\b", 2); return;
+    case '\f': dest->append("\\f", 2); return;
+    case '\n': dest->append("\\n", 2); return;
+    case '\r': dest->append("\\r", 2); return;
+    case '\t': dest->append("\\t", 2); return;
+    case '\"': dest->append("\\\"", 2); return;
+    case '\\': dest->append("\\\\", 2); return;
+  }
+  const char unicode[6] = {'\\', 'u', '0', '0', kHexDigits[c >> 4],
+                           kHexDigits[c & 0x0F]};
+  dest->append(unicode, 6);
+}
+
+inline bool IsOctalDigit(char c) { return c >= '0' && c <= '7'; }
+
+// Reads the 4 hex digits of a \u escape at p[i, i + 4).
+inline bool ReadHex4(const char* p, size_t n, size_t i, uint32_t* value) {
+  if (n - i < 4) return false;
+  uint32_t v = 0;
+  for (size_t j = i; j < i + 4; ++j) {
+    const int digit = HexDigitValue(p[j]);
+    if (digit < 0) return false;
+    v = (v << 4) | digit;
+  }
+  *value = v;
+  return true;
+}
+
+// Restores *dest and reports offset.
+inline bool FailUnescape(string* dest, size_t original_size, size_t offset,
+                         size_t* error_offset) {
+  dest->resize(original_size);
+  return Fail(offset, error_offset);
+}
+
+}  // namespace
+
+void CEscapeAndAppend(StringPiece src, string* dest) {
+  EscapeAndAppend(src, kCSpecial, dest, AppendCEscaped);
+}
+
+string CEscape(StringPiece src) {
+  string result;
+  CEscapeAndAppend(src, &result);
+  return result;
+}
+
+bool CUnescapeAndAppend(StringPiece src, string* dest, size_t* error_offset) {
+  const size_t original_size = dest->size();
+  dest->reserve(original_size + src.size());
+  const char* const p = src.data();
+  const size_t n = src.size();
+  size_t pos = 0;
+  for (;;) {
+    const stringpiece_ssize_type hit = src.find('\\', pos);
+    if (hit < 0) {
+      dest->append(p + pos, n - pos);
+      return true;
+    }
+    dest->append(p + pos, hit - pos);
+    size_t i = hit + 1;
+    if (i == n) {
+      return FailUnescape(dest, original_size, hit, error_offset);
+    }
+    const char c = p[i++];
+    switch (c) {
+      case 'a': dest->push_back('\a'); break;
+      case 'b': dest->push_back('\b'); break;
+      case 'f': dest->push_back('\f'); break;
+      case 'n': dest->push_back('\n'); break;
+      case 'r': dest->push_back('\r'); break;
+      case 't': dest->push_back('\t'); break;
+      case 'v': dest->push_back('\v'); break;
+      case '\\': case '\'': case '\"': case '?':
+        dest->push_back(c);
+        break;
+      case '0': case '1': case '2': case '3':
+      case '4': case '5': case '6': case '7': {
+        // Up to three octal digits, at most \377.
+        unsigned value = c - '0';
+        for (int digits = 1; digits < 3 && i < n && IsOctalDigit(p[i]);
+             ++digits) {
+          value = value * 8 + (p[i++] - '0');
+        }
+        if (value > 0xFF) {
+          return FailUnescape(dest, original_size, hit, error_offset);
+        }
+        dest->push_back(static_cast<char>(value));
+        break;
+      }
+      case 'x': {
+        // One or two hex digits.
+        int value = i < n ? HexDigitValue(p[i]) : -1;
+        if (value < 0) {
+          return FailUnescape(dest, original_size, hit, error_offset);
+        }
+        ++i;
+        if (i < n && HexDigitValue(p[i]) >= 0) {
+          value = value * 16 + HexDigitValue(p[i++]);
+        }
+        dest->push_back(static_cast<char>(value));
+        break;
+      }
+      default:
+        return FailUnescape(dest, original_size, hit, error_offset);
+    }
+    pos = i;
+  }
+}
+
+void JsonEscapeAndAppend(StringPiece src, string* dest) {
+  EscapeAndAppend(src, kJsonSpecial, dest, AppendJsonEscaped);
+}
+
+string JsonEscape(StringPiece src) {
+  string result;
+  JsonEscapeAndAppend(src, &result);
+  return result;
+}
+
+bool JsonUnescapeAndAppend(StringPiece src, string* dest,
+                           size_t* error_offset) {
+  const size_t original_size = dest->size();
+  dest->reserve(original_size + src.size());
+  const char* const p = src.data();
+  const size_t n = src.size();
+  size_t pos = 0;
+  for (;;) {
+    // Escapes start at a backslash; raw quotes and control characters
+    // are errors.  Both are in kJsonSpecial.
+    const stringpiece_ssize_type hit = src.find_first_of(kJsonSpecial, pos);
+    if (hit < 0) {
+      dest->append(p + pos, n - pos);
+      return true;
+    }
+    dest->append(p + pos, hit - pos);
+    size_t i = hit + 1;
+    if (p[hit] != '\\' || i == n) {
+      return FailUnescape(dest, original_size, hit, error_offset);
+    }
+    const char c = p[i++];
+    switch (c) {
+      case 'b': dest->push_back('\b'); break;
+      case 'f': dest->push_back('\f'); break;
+      case 'n': dest->push_back('\n'); break;
+      case 'r': dest->push_back('\r'); break;
+      case 't': dest->push_back('\t'); break;
+      case '\"': case '\\': case '/':
+        dest->push_back(c);
+        break;
+      case 'u': {
+        char32_t code_point;
+        uint32_t unit;
+        if (!ReadHex4(p, n, i, &unit)) {
+          return FailUnescape(dest, original_size, hit, error_offset);
+        }
+        i += 4;
+        code_point = unit;
+        if ((unit & 0xF800) == 0xD800) {
+          // A high surrogate must be followed by an escaped low one.
+          uint32_t low;
+          if (unit >= 0xDC00 || n - i < 2 || p[i] != '\\' ||
+              p[i + 1] != 'u' || !ReadHex4(p, n, i + 2, &low) ||
+              (low & 0xFC00) != 0xDC00) {
+            return FailUnescape(dest, original_size, hit, error_offset);
+          }
+          i += 6;
+          code_point = 0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00);
+        }
+        char utf8[4];
+        dest->append(utf8, Utf32ToUtf8(&code_point, 1, utf8).written);
+        break;
+      }
+      default:
+        return FailUnescape(dest, original_size, hit, error_offset);
+    }
+    pos = i;
+  }
+}
+
+}  // namespace foundation
@@ -0,0 +1,269 @@
+
+#include <foundation/base/event_loop.hpp>
+
+#include <errno.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <system_error>
+
+namespace foundation {
+
+namespace {
+
+const int kMaxEvents = 64;
+
+void ThrowErrno(const char* what)
+{
+  throw std::system_error(errno, std::generic_category(), what);
+}
+
+uint32_t ToEpoll(uint32_t events)
+{
+  uint32_t result = EPOLLET;
+  if (events & EventLoop::kReadable) result |= EPOLLIN | EPOLLRDHUP;
+  if (events & EventLoop::kWritable) result |= EPOLLOUT;
+  return result;
+}
+
+uint32_t FromEpoll(uint32_t events)
+{
+  uint32_t result = 0;
+  if (events & (EPOLLIN | EPOLLRDHUP)) result |= EventLoop::kReadable;
+  if (events & EPOLLOUT) result |= EventLoop::kWritable;
+  if (events & (EPOLLHUP | EPOLLRDHUP)) result |= EventLoop::kHangup;
+  if (events & EPOLLERR) result |= EventLoop::kError;
+  return result;
+}
+
+// Reads until the counter is empty; timerfd and eventfd are non-blocking.
+void Drain(int fd)
+{
+  uint64_t count;
+  while (read(fd, &count, sizeof(count)) > 0) {
+  }
+}
+
+}  // namespace
+
+const uint32_t EventLoop::kReadable;
+const uint32_t EventLoop::kWritable;
+const uint32_t EventLoop::kHangup;
+const uint32_t EventLoop::kError;
+
+EventLoop::EventLoop()
+  : epoll_fd_(-1),
+    timer_fd_(-1),
+    wake_fd_(-1),
+    armed_(TimerClock::time_point::max()),
+    stop_(false),
+    wake_pending_(false),
+    observer_(this)
+{
+  // timerfd's CLOCK_MONOTONIC is the clock behind std::chrono::steady_clock
+  // on Linux, so timer deadlines can be armed as they are.
+  const char* failed = NULL;
+  epoll_event timer_event = {};
+  timer_event.events = EPOLLIN;
+  timer_event.data.ptr = &timer_fd_;
+  epoll_event wake_event = {};
+  wake_event.events = EPOLLIN;
+  wake_event.data.ptr = &wake_fd_;
+  if ((epoll_fd_ = epoll_create1(EPOLL_CLOEXEC)) < 0) {
+    failed = "epoll_create1";
+  } else if ((timer_fd_ = timerfd_create(CLOCK_MONOTONIC,
+                                         TFD_NONBLOCK | TFD_CLOEXEC)) < 0) {
+    failed = "timerfd_create";
+  } else if ((wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) < 0) {
+    failed = "eventfd";
+  } else if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, timer_fd_,
+                       &timer_event) != 0 ||
+             epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_,
+                       &wake_event) != 0) {
+    failed = "epoll_ctl(EPOLL_CTL_ADD)";
+  }
+  if (failed != NULL) {
+    const std::system_error error(errno, std::generic_category(), failed);
+    if (epoll_fd_ >= 0) close(epoll_fd_);
+    if (timer_fd_ >= 0) close(timer_fd_);
+    if (wake_fd_ >= 0) close(wake_fd_);
+    throw error;
+  }
+
+  AddTimerObserver(&observer_);
+}
+
+EventLoop::~EventLoop()
+{
+  RemoveTimerObserver(&observer_);
+  close(epoll_fd_);
+  close(timer_fd_);
+  close(wake_fd_);
+}
+
+void EventLoop::Add(int fd, uint32_t events, Handler handler)
+{
+  std::unique_ptr<Registration> registration(new Registration);
+  registration->fd = fd;
+  registration->handler = std::move(handler);
+  registration->removed = false;
+
+  epoll_event event = {};
+  event.events = ToEpoll(events);
+  event.data.ptr = registration.get();
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) != 0) {
+    ThrowErrno("epoll_ctl(EPOLL_CTL_ADD)");
+  }
+  registrations_[fd] = std::move(registration);
+}
+
+void EventLoop::Modify(int fd, uint32_t events)
+{
+  auto it = registrations_.find(fd);
+  if (it == registrations_.end()) {
+    errno = ENOENT;
+    ThrowErrno("EventLoop::Modify");
+  }
+  epoll_event event = {};
+  event.events = ToEpoll(events);
+  event.data.ptr = it->second.get();
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &event) != 0) {
+    ThrowErrno("epoll_ctl(EPOLL_CTL_MOD)");
+  }
+}
+
+void EventLoop::Remove(int fd)
+{
+  auto it = registrations_.find(fd);
+  if (it == registrations_.end()) {
+    return;
+  }
+  epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, NULL);
+  it->second->removed = true;
+  retired_.push_back(std::move(it->second));
+  registrations_.erase(it);
+}
+
+void EventLoop::Run()
+{
+  while (!stop_.exchange(false, std::memory_order_acq_rel)) {
+    RunOnce(-1);
+  }
+}
+
+int EventLoop::RunOnce(int timeout_ms)
+{
+  ArmTimer();
+
+  epoll_event events[kMaxEvents];
+  const int n = epoll_wait(epoll_fd_, events, kMaxEvents, timeout_ms);
+  if (n < 0 && errno != EINTR) {
+    ThrowErrno("epoll_wait");
+  }
+
+  int handled = 0;
+  bool timers_due = false;
+  for (int i = 0; i < n; ++i) {
+    void* tag = events[i].data.ptr;
+    if (tag == &timer_fd_) {
+      Drain(timer_fd_);
+      armed_ = TimerClock::time_point::max();
+      timers_due = true;
+    } else if (tag == &wake_fd_) {
+      // Drained before clearing: clearing first would let a racing
+      // Wake() write, have the drain swallow it, and leave the flag set
+      // for good.  A Wake() that still sees the flag set skips its write,
+      // which is safe because posted work and stop_ are checked after
+      // this batch.
+      Drain(wake_fd_);
+      wake_pending_.store(false, std::memory_order_release);
+    } else {
+      Registration* registration = static_cast<Registration*>(tag);
+      if (!registration->removed) {
+        registration->handler(registration->fd, FromEpoll(events[i].events));
+        ++handled;
+      }
+    }
+  }
+
+  if (timers_due) {
+    UpdateTimers();
+  }
+  RunPosted();
+  retired_.clear();
+  return handled;
+}
+
+void EventLoop::Stop()
+{
+  stop_.store(true, std::memory_order_release);
+  Wake();
+}
+
+void EventLoop::Post(std::function<void()> fn)
+{
+  {
+    std::lock_guard<std::mutex> lock(posted_mutex_);
+    posted_.push_back(std::move(fn));
+  }
+  Wake();
+}
+
+void EventLoop::TimersEarlier(TimerObserver* observer)
+{
+  static_cast<Observer*>(observer)->loop->Wake();
+}
+
+void EventLoop::Wake()
+{
+  if (!wake_pending_.exchange(true, std::memory_order_acq_rel)) {
+    const uint64_t one = 1;
+    // Can only fail if the counter would overflow, which still wakes us.
+    ssize_t written = write(wake_fd_, &one, sizeof(one));
+    (void)written;
+  }
+}
+
+void EventLoop::ArmTimer()
+{
+  TimerClock::time_point deadline;
+  if (!NextTimerDeadline(&deadline)) {
+    deadline = TimerClock::time_point::max();
+  }
+  if (deadline == armed_) {
+    return;
+  }
+
+  itimerspec spec = {};
+  if (deadline != TimerClock::time_point::max()) {
+    int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        deadline.time_since_epoch()).count();
+    if (ns <= 0) ns = 1;  // An all-zero it_value disarms.
+    spec.it_value.tv_sec = ns / 1000000000;
+    spec.it_value.tv_nsec = ns % 1000000000;
+  }
+  if (timerfd_settime(timer_fd_, TFD_TIMER_ABSTIME, &spec, NULL) != 0) {
+    ThrowErrno("timerfd_settime");
+  }
+  armed_ = deadline;
+}
+
+void EventLoop::RunPosted()
+{
+  std::vector<std::function<void()> > posted;
+  {
+    std::lock_guard<std::mutex> lock(posted_mutex_);
+    if (posted_.empty()) {
+      return;
+    }
+    posted.swap(posted_);
+  }
+  for (size_t i = 0; i < posted.size(); ++i) {
+    posted[i]();
+  }
+}
+
+}  // namespace foundation
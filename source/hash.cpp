@@ -0,0 +1,259 @@
+
+#include <foundation/strings/hash.hpp>
+
+#include <string.h>
+
+#if (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define HASH_HAVE_X86_SIMD 1
+#endif
+
+namespace foundation {
+
+namespace {
+
+const uint64_t kSecret0 = 0xa0761d6478bd642fULL;
+const uint64_t kSecret1 = 0xe7037ed1a0b428dbULL;
+const uint64_t kSecret2 = 0x8ebc6af09c88c6e3ULL;
+const uint64_t kSecret3 = 0x589965cc75374cc3ULL;
+
+// Keys for the long-input lanes.  Stripe s of a block uses words
+// [s, s + 8), the scramble uses [16, 24).
+const uint64_t kStripeKeys[24] = {
+    0x2cb0f69f4abea221ULL, 0x9417034723148989ULL, 0xdd555950609dfe03ULL,
+    0xdbafb150deb12800ULL, 0x7e789b2e6c442cb6ULL, 0xf41e5636c7e4f8c4ULL,
+    0x0959d150f8fba7e4ULL, 0xa97316f13cdb9eeaULL, 0x74cd8258f9520068ULL,
+    0x55c74a62e116868bULL, 0xd2f4c799a2023cbdULL, 0xdf98cb79a37b51b9ULL,
+    0x396f5885524f3905ULL, 0xaf1d56386ca3b276ULL, 0xa9ffbe6b5104e85aULL,
+    0x6bd0c51b9fd533b3ULL, 0x980ce91c50ab4b56ULL, 0x28ac395780fe62c5ULL,
+    0x768912e3a6bcedc7ULL, 0x50b3e8c9332c7c88ULL, 0xce3bbfe520bd47daULL,
+    0xcba6c8e8e0bb7c4fULL, 0xbf194db8434a346dULL, 0x7d8f2a7b60416d7fULL,
+};
+
+const size_t kStripeLen = 64;
+const size_t kStripesPerBlock = 16;
+const size_t kBlockLen = kStripeLen * kStripesPerBlock;
+const size_t kLongInput = 1024;
+const uint32_t kScrambleMul = 0x9E3779B1U;
+
+inline uint64_t Read64(const char* p) {
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+inline uint64_t Read32(const char* p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+// Sets *a and *b to the low and high halves of *a * *b.
+inline void Multiply128(uint64_t* a, uint64_t* b) {
+#if defined(__SIZEOF_INT128__)
+  unsigned __int128 r = static_cast<unsigned __int128>(*a) * *b;
+  *a = static_cast<uint64_t>(r);
+  *b = static_cast<uint64_t>(r >> 64);
+#else
+  const uint64_t ha = *a >> 32, hb = *b >> 32;
+  const uint64_t la = static_cast<uint32_t>(*a), lb = static_cast<uint32_t>(*b);
+  const uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+  const uint64_t t = rl + (rm0 << 32);
+  uint64_t carry = t < rl;
+  const uint64_t lo = t + (rm1 << 32);
+  carry += lo < t;
+  *a = lo;
+  *b = rh + (rm0 >> 32) + (rm1 >> 32) + carry;
+#endif
+}
+
+inline uint64_t Mix(uint64_t a, uint64_t b) {
+  Multiply128(&a, &b);
+  return a ^ b;
+}
+
+// ---------------------------------------------------------------------
+// Long inputs: eight 64-bit accumulators.  For each 8-byte word w of a
+// stripe, with k = w ^ key:
+//   acc[i]     += (k & 0xffffffff) * (k >> 32)
+//   acc[i ^ 1] += w
+// and after every block each accumulator is scrambled.  The kernels
+// below are three renderings of exactly this.
+// ---------------------------------------------------------------------
+
+typedef void (*AccumulateFn)(uint64_t* acc, const char* p, size_t stripes,
+                             const uint64_t* keys);
+typedef void (*ScrambleFn)(uint64_t* acc, const uint64_t* keys);
+
+void AccumulateScalar(uint64_t* acc, const char* p, size_t stripes,
+                      const uint64_t* keys) {
+  for (size_t s = 0; s < stripes; ++s, p += kStripeLen) {
+    for (int i = 0; i < 8; ++i) {
+      const uint64_t w = Read64(p + 8 * i);
+      const uint64_t k = w ^ keys[s + i];
+      acc[i ^ 1] += w;
+      acc[i] += (k & 0xffffffffU) * (k >> 32);
+    }
+  }
+}
+
+void ScrambleScalar(uint64_t* acc, const uint64_t* keys) {
+  for (int i = 0; i < 8; ++i) {
+    uint64_t a = acc[i];
+    a ^= a >> 47;
+    a ^= keys[i];
+    acc[i] = a * kScrambleMul;
+  }
+}
+
+#ifdef HASH_HAVE_X86_SIMD
+
+__attribute__((target("sse2")))
+void AccumulateSse2(uint64_t* acc, const char* p, size_t stripes,
+                    const uint64_t* keys) {
+  __m128i a[4];
+  for (int i = 0; i < 4; ++i) {
+    a[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(acc) + i);
+  }
+  for (size_t s = 0; s < stripes; ++s, p += kStripeLen) {
+    for (int i = 0; i < 4; ++i) {
+      const __m128i w =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(p) + i);
+      const __m128i key =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys + s) + i);
+      const __m128i k = _mm_xor_si128(w, key);
+      // _mm_mul_epu32 multiplies the low 32 bits of each 64-bit lane.
+      const __m128i product =
+          _mm_mul_epu32(k, _mm_shuffle_epi32(k, _MM_SHUFFLE(0, 3, 0, 1)));
+      const __m128i swapped = _mm_shuffle_epi32(w, _MM_SHUFFLE(1, 0, 3, 2));
+      a[i] = _mm_add_epi64(a[i], _mm_add_epi64(product, swapped));
+    }
+  }
+  for (int i = 0; i < 4; ++i) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(acc) + i, a[i]);
+  }
+}
+
+__attribute__((target("avx2")))
+void AccumulateAvx2(uint64_t* acc, const char* p, size_t stripes,
+                    const uint64_t* keys) {
+  __m256i a0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc));
+  __m256i a1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc) + 1);
+  for (size_t s = 0; s < stripes; ++s, p += kStripeLen) {
+    const __m256i w0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    const __m256i w1 =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p) + 1);
+    const __m256i k0 = _mm256_xor_si256(
+        w0, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + s)));
+    const __m256i k1 = _mm256_xor_si256(
+        w1, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + s) + 1));
+    const __m256i p0 = _mm256_mul_epu32(
+        k0, _mm256_shuffle_epi32(k0, _MM_SHUFFLE(0, 3, 0, 1)));
+    const __m256i p1 = _mm256_mul_epu32(
+        k1, _mm256_shuffle_epi32(k1, _MM_SHUFFLE(0, 3, 0, 1)));
+    a0 = _mm256_add_epi64(
+        a0, _mm256_add_epi64(p0, _mm256_shuffle_epi32(w0, _MM_SHUFFLE(1, 0, 3, 2))));
+    a1 = _mm256_add_epi64(
+        a1, _mm256_add_epi64(p1, _mm256_shuffle_epi32(w1, _MM_SHUFFLE(1, 0, 3, 2))));
+  }
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(acc), a0);
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(acc) + 1, a1);
+}
+
+#endif  // HASH_HAVE_X86_SIMD
+
+AccumulateFn ResolveAccumulate() {
+#ifdef HASH_HAVE_X86_SIMD
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) return AccumulateAvx2;
+  if (__builtin_cpu_supports("sse2")) return AccumulateSse2;
+#endif
+  return AccumulateScalar;
+}
+
+inline void Accumulate(uint64_t* acc, const char* p, size_t stripes,
+                       const uint64_t* keys) {
+  static const AccumulateFn accumulate = ResolveAccumulate();
+  accumulate(acc, p, stripes, keys);
+}
+
+uint64_t HashLong(const char* p, size_t len, uint64_t seed) {
+  uint64_t acc[8] = {
+      kSecret0 ^ seed, kSecret1, kSecret2, kSecret3,
+      kSecret0, kSecret1 ^ seed, kSecret2, kSecret3,
+  };
+  const char* const end = p + len;
+
+  // Whole blocks, then the remaining whole stripes, then the last 64
+  // bytes of input (which may overlap what came before).
+  const size_t blocks = (len - 1) / kBlockLen;
+  for (size_t b = 0; b < blocks; ++b, p += kBlockLen) {
+    Accumulate(acc, p, kStripesPerBlock, kStripeKeys);
+    ScrambleScalar(acc, kStripeKeys + 16);
+  }
+  const size_t stripes = (end - p - 1) / kStripeLen;
+  Accumulate(acc, p, stripes, kStripeKeys);
+  Accumulate(acc, end - kStripeLen, 1, kStripeKeys + 7);
+
+  uint64_t h = len * kSecret0 ^ seed;
+  for (int i = 0; i < 8; i += 2) {
+    h += Mix(acc[i] ^ kStripeKeys[16 + i], acc[i + 1] ^ kStripeKeys[17 + i]);
+  }
+  h ^= h >> 37;
+  h *= 0x165667919E3779F9ULL;
+  h ^= h >> 32;
+  return h;
+}
+
+}  // namespace
+
+uint64_t Hash64(const char* p, size_t len, uint64_t seed) {
+  if (len > kLongInput) {
+    return HashLong(p, len, seed);
+  }
+
+  seed ^= Mix(seed ^ kSecret0, kSecret1);
+  uint64_t a, b;
+  if (len <= 16) {
+    if (len >= 4) {
+      // Two overlapping pairs of 32-bit reads cover 4..16 bytes.
+      const size_t mid = (len >> 3) << 2;
+      a = (Read32(p) << 32) | Read32(p + mid);
+      b = (Read32(p + len - 4) << 32) | Read32(p + len - 4 - mid);
+    } else if (len > 0) {
+      const unsigned char* u = reinterpret_cast<const unsigned char*>(p);
+      a = (static_cast<uint64_t>(u[0]) << 16) |
+          (static_cast<uint64_t>(u[len >> 1]) << 8) | u[len - 1];
+      b = 0;
+    } else {
+      a = b = 0;
+    }
+  } else {
+    size_t i = len;
+    if (i > 48) {
+      uint64_t see1 = seed, see2 = seed;
+      do {
+        seed = Mix(Read64(p) ^ kSecret1, Read64(p + 8) ^ seed);
+        see1 = Mix(Read64(p + 16) ^ kSecret2, Read64(p + 24) ^ see1);
+        see2 = Mix(Read64(p + 32) ^ kSecret3, Read64(p + 40) ^ see2);
+        p += 48;
+        i -= 48;
+      } while (i > 48);
+      seed ^= see1 ^ see2;
+    }
+    while (i > 16) {
+      seed = Mix(Read64(p) ^ kSecret1, Read64(p + 8) ^ seed);
+      i -= 16;
+      p += 16;
+    }
+    a = Read64(p + i - 16);
+    b = Read64(p + i - 8);
+  }
+  a ^= kSecret1;
+  b ^= seed;
+  Multiply128(&a, &b);
+  return Mix(a ^ kSecret0 ^ len, b ^ kSecret1);
+}
+
+}  // namespace foundation
@@ -0,0 +1,113 @@
+
+#include <foundation/uuid/id_allocator.hpp>
+
+#include <stdexcept>
+
+namespace foundation {
+
+namespace {
+
+// Each thread caches one batch for each of a few allocators, indexed by
+// the allocator's serial number.  Serials are never reused, so a stale
+// slot left by a destroyed allocator is simply a miss.  Two live
+// allocators that share a slot still work, but evict each other's batch.
+const int kCacheSlots = 8;
+
+struct CachedBatch {
+  uint64_t serial;  // 0: empty.
+  uint64_t next;
+  uint64_t end;
+};
+
+thread_local CachedBatch t_batches[kCacheSlots];
+
+std::atomic<uint64_t> g_next_serial(1);
+
+}  // namespace
+
+IdAllocator::IdAllocator()
+{
+  Init(Options());
+}
+
+IdAllocator::IdAllocator(const Options& options)
+{
+  Init(options);
+}
+
+void IdAllocator::Init(const Options& options)
+{
+  const int reserved = options.epoch_bits + options.shard_bits;
+  if (options.epoch_bits < 0 || options.shard_bits < 0 || reserved >= 64) {
+    throw std::invalid_argument("IdAllocator: too many epoch/shard bits");
+  }
+  const int sequence_bits = 64 - reserved;
+  shard_shift_ = sequence_bits;
+  epoch_shift_ = sequence_bits + options.shard_bits;
+  sequence_mask_ = ~uint64_t(0) >> reserved;
+  shard_mask_ = options.shard_bits == 0
+      ? 0 : (~uint64_t(0) >> (64 - options.shard_bits));
+  const uint64_t epoch_mask = options.epoch_bits == 0
+      ? 0 : (~uint64_t(0) >> (64 - options.epoch_bits));
+  if ((options.epoch & ~epoch_mask) != 0 ||
+      (options.shard & ~shard_mask_) != 0 ||
+      (options.first & ~sequence_mask_) != 0) {
+    throw std::invalid_argument("IdAllocator: field does not fit its bits");
+  }
+  prefix_ = (options.epoch_bits == 0 ? 0 : options.epoch << epoch_shift_) |
+            (options.shard_bits == 0 ? 0 : options.shard << shard_shift_);
+  batch_size_ = options.batch_size == 0 ? 1 : options.batch_size;
+  serial_ = g_next_serial.fetch_add(1, std::memory_order_relaxed);
+  next_.store(options.first, std::memory_order_relaxed);
+}
+
+uint64_t IdAllocator::Next()
+{
+  CachedBatch& batch = t_batches[serial_ % kCacheSlots];
+  if (batch.serial == serial_ && batch.next != batch.end) {
+    return prefix_ | batch.next++;
+  }
+  return Refill();
+}
+
+uint64_t IdAllocator::Refill()
+{
+  const uint64_t begin =
+      next_.fetch_add(batch_size_, std::memory_order_relaxed);
+  // The counter only ever grows, so once a batch starts past the
+  // sequence space every later one will too.  (Wrapping all 64 bits
+  // would take centuries.)
+  if (begin > sequence_mask_) {
+    throw std::overflow_error("IdAllocator: sequence space exhausted");
+  }
+  uint64_t end = begin + batch_size_;
+  if (end > sequence_mask_ || end < begin) {
+    end = sequence_mask_ + 1;  // Wraps to 0 without reserved bits; fine.
+  }
+  CachedBatch& batch = t_batches[serial_ % kCacheSlots];
+  batch.serial = serial_;
+  batch.next = begin + 1;
+  batch.end = end;
+  return prefix_ | begin;
+}
+
+uint64_t IdAllocator::EpochOf(uint64_t id) const
+{
+  return epoch_shift_ == 64 ? 0 : id >> epoch_shift_;
+}
+
+uint64_t IdAllocator::ShardOf(uint64_t id) const
+{
+  return shard_shift_ == 64 ? 0 : (id >> shard_shift_) & shard_mask_;
+}
+
+IdAllocator* IdAllocator::Default()
+{
+  // A static object rather than new: operator new is not required to
+  // honour the 64-byte alignment before C++17.  Destruction is trivial, so
+  // use during static destruction is still safe.
+  static IdAllocator allocator;
+  return &allocator;
+}
+
+}  // namespace foundation
@@ -0,0 +1,146 @@
+
+#include <foundation/strings/intern.hpp>
+
+#include <foundation/strings/hash.hpp>
+
+#include <string.h>
+
+namespace foundation {
+
+using internal::InternEntry;
+
+InternPool::Table::Table(size_t capacity)
+  : mask(capacity - 1),
+    slots(capacity)
+{
+  for (size_t i = 0; i < capacity; ++i) {
+    slots[i].store(NULL, std::memory_order_relaxed);
+  }
+}
+
+InternPool::Shard::Shard()
+  : table(new Table(64)),
+    arena(4096),
+    count(0)
+{}
+
+InternPool::InternPool()
+{}
+
+InternPool::~InternPool()
+{
+  for (int i = 0; i < kShards; ++i) {
+    delete shards_[i].table.load(std::memory_order_relaxed);
+    for (size_t j = 0; j < shards_[i].retired.size(); ++j) {
+      delete shards_[i].retired[j];
+    }
+  }
+}
+
+InternPool* InternPool::Default()
+{
+  // Never destroyed, so handles stay valid during static destruction.
+  static InternPool* pool = new InternPool();
+  return pool;
+}
+
+const InternEntry* InternPool::Lookup(const Table* table, StringPiece s,
+                                      uint64_t hash)
+{
+  for (size_t i = hash & table->mask;; i = (i + 1) & table->mask) {
+    const InternEntry* entry = table->slots[i].load(std::memory_order_acquire);
+    if (entry == NULL) {
+      return NULL;
+    }
+    if (entry->hash == hash && entry->size == static_cast<size_t>(s.size()) &&
+        memcmp(entry->data(), s.data(), s.size()) == 0) {
+      return entry;
+    }
+  }
+}
+
+void InternPool::Insert(Table* table, const InternEntry* entry)
+{
+  size_t i = entry->hash & table->mask;
+  while (table->slots[i].load(std::memory_order_relaxed) != NULL) {
+    i = (i + 1) & table->mask;
+  }
+  table->slots[i].store(entry, std::memory_order_release);
+}
+
+InternedString InternPool::Find(StringPiece s) const
+{
+  const uint64_t hash = Hash64(s.data(), s.size());
+  Shard& shard = ShardFor(hash);
+  const InternEntry* entry =
+      Lookup(shard.table.load(std::memory_order_acquire), s, hash);
+  if (entry == NULL) {
+    // A concurrent Intern() may have just grown the table; look again
+    // under the lock before reporting a miss.
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    entry = Lookup(shard.table.load(std::memory_order_relaxed), s, hash);
+  }
+  return InternedString(entry);
+}
+
+InternedString InternPool::Intern(StringPiece s)
+{
+  const uint64_t hash = Hash64(s.data(), s.size());
+  Shard& shard = ShardFor(hash);
+
+  // Fast path: already interned, no lock.
+  const InternEntry* entry =
+      Lookup(shard.table.load(std::memory_order_acquire), s, hash);
+  if (entry != NULL) {
+    return InternedString(entry);
+  }
+
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  Table* table = shard.table.load(std::memory_order_relaxed);
+  entry = Lookup(table, s, hash);
+  if (entry != NULL) {
+    return InternedString(entry);
+  }
+
+  // Keep the load factor under 3/4.  Readers may still be probing the old
+  // table, so it is retired rather than freed.
+  if ((shard.count + 1) * 4 > (table->mask + 1) * 3) {
+    Table* bigger = new Table((table->mask + 1) * 2);
+    for (size_t i = 0; i <= table->mask; ++i) {
+      const InternEntry* e = table->slots[i].load(std::memory_order_relaxed);
+      if (e != NULL) {
+        Insert(bigger, e);
+      }
+    }
+    shard.retired.push_back(table);
+    shard.table.store(bigger, std::memory_order_release);
+    table = bigger;
+  }
+
+  void* memory = shard.arena.Allocate(sizeof(InternEntry) + s.size() + 1,
+                                      alignof(InternEntry));
+  InternEntry* created = static_cast<InternEntry*>(memory);
+  created->hash = hash;
+  created->size = s.size();
+  char* data = reinterpret_cast<char*>(created + 1);
+  if (s.size() > 0) {
+    memcpy(data, s.data(), s.size());
+  }
+  data[s.size()] = '\0';
+
+  Insert(table, created);
+  ++shard.count;
+  return InternedString(created);
+}
+
+size_t InternPool::size() const
+{
+  size_t total = 0;
+  for (int i = 0; i < kShards; ++i) {
+    std::lock_guard<std::mutex> lock(shards_[i].mutex);
+    total += shards_[i].count;
+  }
+  return total;
+}
+
+}  // namespace foundation
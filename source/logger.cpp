@@ -1,11 +1,50 @@
 
 #include <foundation/logger/logger.hpp>
+#include <foundation/base/trace.hpp>
+#include <foundation/strings/numbers.hpp>
+
+#include <time.h>
 
 #include <iostream>
 #include <vector>
 
 //Mutex mutex;
 std::vector<std::pair<Logger*, int> > loggers;
+LogTimestamp timestampFormat = LogTimestamp::ISO8601;
+
+
+namespace
+{
+
+// Returns line with the timestamp in front.  The record is built in a
+// per-thread string, so once it has grown to the longest line no
+// allocation is needed.
+std::string const& StampLine( std::string const& line )
+{
+  static thread_local std::string record;
+
+  timespec now;
+  clock_gettime( CLOCK_REALTIME, &now );
+
+  char buffer[foundation::kFastToBufferSize];
+  char const* stamp;
+  if ( timestampFormat == LogTimestamp::RFC822 )
+  {
+    stamp = foundation::FastTimeToBuffer( now.tv_sec, buffer );
+  }
+  else
+  {
+    stamp = foundation::FastIso8601TimeToBuffer(
+      now.tv_sec, static_cast<int32_t>( now.tv_nsec / 1000 ), buffer );
+  }
+
+  record.assign( stamp );
+  record += ' ';
+  record += line;
+  return record;
+}
+
+}
 
 
 BasicLogger::BasicLogger(std::ostream& os) :
@@ -29,15 +68,27 @@ void RegisterLogger( Logger* logger, int threshold )
   loggers.push_back( std::make_pair(logger, threshold) );
 }
 
+void SetLogTimestamp( LogTimestamp format )
+{
+  timestampFormat = format;
+}
+
 void SendToLogger( int level, std::string const& line )
 {
+  TRACE_SCOPE( "logger", "SendToLogger" );
   //Locker lock(muxtex);
 
+  // Only pay for the timestamp if someone is listening.
+  std::string const* record = NULL;
   for ( auto i : loggers )
   {
     if ( level >= i.second )
     {
-      i.first->write( line );
+      if ( record == NULL )
+      {
+        record = timestampFormat == LogTimestamp::NONE ? &line : &StampLine( line );
+      }
+      i.first->write( *record );
     }
   }
 }
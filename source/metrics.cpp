@@ -0,0 +1,324 @@
+
+#include <foundation/base/metrics.hpp>
+
+#include <foundation/strings/ascii_ctype.hpp>
+#include <foundation/strings/numbers.hpp>
+#include <foundation/strings/strcat.hpp>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <new>
+#include <stdexcept>
+
+namespace foundation {
+namespace metrics {
+
+namespace internal {
+
+int AssignShard()
+{
+  static std::atomic<unsigned> next(0);
+  return static_cast<int>(next.fetch_add(1, std::memory_order_relaxed) %
+                          kShards);
+}
+
+void* CacheLineAligned::operator new(size_t size)
+{
+  void* p = NULL;
+  if (posix_memalign(&p, 64, size) != 0) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void CacheLineAligned::operator delete(void* p)
+{
+  free(p);
+}
+
+}  // namespace internal
+
+Counter::Counter()
+{
+  for (int i = 0; i < kShards; ++i) {
+    cells_[i].value.store(0, std::memory_order_relaxed);
+  }
+}
+
+uint64_t Counter::Value() const
+{
+  uint64_t total = 0;
+  for (int i = 0; i < kShards; ++i) {
+    total += cells_[i].value.load(std::memory_order_relaxed);
+  }
+  return total;
+}
+
+Histogram::Histogram()
+{
+  for (int i = 0; i < kShards; ++i) {
+    cells_[i].sum.store(0, std::memory_order_relaxed);
+    for (int b = 0; b < kBuckets; ++b) {
+      cells_[i].buckets[b].store(0, std::memory_order_relaxed);
+    }
+  }
+}
+
+Histogram::Snapshot Histogram::GetSnapshot() const
+{
+  Snapshot snapshot;
+  snapshot.count = 0;
+  snapshot.sum = 0;
+  snapshot.buckets.assign(kBuckets, 0);
+  for (int i = 0; i < kShards; ++i) {
+    snapshot.sum += cells_[i].sum.load(std::memory_order_relaxed);
+    for (int b = 0; b < kBuckets; ++b) {
+      snapshot.buckets[b] +=
+          cells_[i].buckets[b].load(std::memory_order_relaxed);
+    }
+  }
+  for (int b = 0; b < kBuckets; ++b) {
+    snapshot.count += snapshot.buckets[b];
+  }
+  return snapshot;
+}
+
+namespace {
+
+bool IsValidName(StringPiece name)
+{
+  if (name.empty()) {
+    return false;
+  }
+  for (stringpiece_ssize_type i = 0; i < name.size(); ++i) {
+    const char c = name[i];
+    if (!(ascii_isalpha(c) || c == '_' || c == ':' ||
+          (i > 0 && ascii_isdigit(c)))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void AppendUInt(std::string* out, uint64_t value)
+{
+  char buffer[kFastToBufferSize];
+  out->append(buffer, FastUInt64ToBufferLeft(value, buffer) - buffer);
+}
+
+// The shortest of %.15g and %.17g that reads back as the same double.
+void AppendDouble(std::string* out, double value)
+{
+  if (isnan(value)) {
+    out->append("NaN");
+    return;
+  }
+  if (isinf(value)) {
+    out->append(value > 0 ? "+Inf" : "-Inf");
+    return;
+  }
+  char buffer[kFastToBufferSize];
+  snprintf(buffer, sizeof(buffer), "%.15g", value);
+  if (strtod(buffer, NULL) != value) {
+    snprintf(buffer, sizeof(buffer), "%.17g", value);
+  }
+  out->append(buffer);
+}
+
+// HELP text escapes backslash and newline.
+void AppendHelp(std::string* out, const std::string& help)
+{
+  for (size_t i = 0; i < help.size(); ++i) {
+    if (help[i] == '\\') {
+      out->append("\\\\");
+    } else if (help[i] == '\n') {
+      out->append("\\n");
+    } else {
+      out->push_back(help[i]);
+    }
+  }
+}
+
+// name{labels} or name{labels,extra} or just name.
+void AppendSeries(std::string* out, const std::string& name,
+                  StringPiece suffix, const std::string& labels,
+                  StringPiece extra)
+{
+  StrAppend(out, name, suffix);
+  if (labels.empty() && extra.empty()) {
+    out->push_back(' ');
+    return;
+  }
+  out->push_back('{');
+  out->append(labels);
+  if (!labels.empty() && !extra.empty()) {
+    out->push_back(',');
+  }
+  StrAppend(out, extra, "} ");
+}
+
+}  // namespace
+
+Registry::Registry()
+{}
+
+Registry::~Registry()
+{}
+
+Registry* Registry::Default()
+{
+  static Registry* registry = new Registry();
+  return registry;
+}
+
+Registry::Entry* Registry::FindOrAdd(StringPiece name, StringPiece help,
+                                     StringPiece labels, Type type)
+{
+  if (!IsValidName(name)) {
+    throw std::invalid_argument(
+        StrCat("metrics: invalid metric name \"", name, "\""));
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  Entry* found = NULL;
+  for (size_t i = 0; i < entries_.size(); ++i) {
+    Entry* entry = entries_[i].get();
+    if (entry->name != name) {
+      continue;
+    }
+    if (entry->type != type) {
+      throw std::invalid_argument(
+          StrCat("metrics: \"", name, "\" is registered as another type"));
+    }
+    if (entry->labels == labels) {
+      found = entry;
+      break;
+    }
+  }
+  if (found != NULL) {
+    return found;
+  }
+
+  std::unique_ptr<Entry> entry(new Entry);
+  entry->name = name.ToString();
+  entry->labels = labels.ToString();
+  entry->help = help.ToString();
+  entry->type = type;
+  switch (type) {
+    case kCounter:
+      entry->counter.reset(new Counter);
+      break;
+    case kGauge:
+      entry->gauge.reset(new Gauge);
+      break;
+    case kHistogram:
+      entry->histogram.reset(new Histogram);
+      break;
+  }
+  entries_.push_back(std::move(entry));
+  return entries_.back().get();
+}
+
+Counter* Registry::GetCounter(StringPiece name, StringPiece help,
+                              StringPiece labels)
+{
+  return FindOrAdd(name, help, labels, kCounter)->counter.get();
+}
+
+Gauge* Registry::GetGauge(StringPiece name, StringPiece help,
+                          StringPiece labels)
+{
+  return FindOrAdd(name, help, labels, kGauge)->gauge.get();
+}
+
+Histogram* Registry::GetHistogram(StringPiece name, StringPiece help,
+                                  StringPiece labels)
+{
+  return FindOrAdd(name, help, labels, kHistogram)->histogram.get();
+}
+
+void Registry::WritePrometheusText(std::string* out) const
+{
+  static const char* const kTypeNames[] = {"counter", "gauge", "histogram"};
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<const Entry*> sorted;
+  sorted.reserve(entries_.size());
+  for (size_t i = 0; i < entries_.size(); ++i) {
+    sorted.push_back(entries_[i].get());
+  }
+  // Stable, so series within a family keep their registration order and
+  // the family's help text is the first one registered.
+  std::stable_sort(sorted.begin(), sorted.end(),
+                   [](const Entry* a, const Entry* b) {
+                     return a->name < b->name;
+                   });
+
+  for (size_t i = 0; i < sorted.size(); ++i) {
+    const Entry& entry = *sorted[i];
+    if (i == 0 || sorted[i - 1]->name != entry.name) {
+      StrAppend(out, "# HELP ", entry.name, " ");
+      AppendHelp(out, entry.help);
+      StrAppend(out, "\n# TYPE ", entry.name, " ", kTypeNames[entry.type]);
+      out->push_back('\n');
+    }
+
+    switch (entry.type) {
+      case kCounter:
+        AppendSeries(out, entry.name, "", entry.labels, "");
+        AppendUInt(out, entry.counter->Value());
+        out->push_back('\n');
+        break;
+
+      case kGauge:
+        AppendSeries(out, entry.name, "", entry.labels, "");
+        AppendDouble(out, entry.gauge->Value());
+        out->push_back('\n');
+        break;
+
+      case kHistogram: {
+        const Histogram::Snapshot snapshot = entry.histogram->GetSnapshot();
+        int first = 0;
+        int last = -1;
+        for (int b = 0; b < Histogram::kBuckets; ++b) {
+          if (snapshot.buckets[b] != 0) {
+            if (last < 0) first = b;
+            last = b;
+          }
+        }
+        // The last finite bucket's bound would be 2^64 - 1, which is
+        // what +Inf already says.
+        last = std::min(last, Histogram::kBuckets - 2);
+
+        uint64_t cumulative = 0;
+        char le[kFastToBufferSize + 8];
+        for (int b = first; b <= last; ++b) {
+          cumulative += snapshot.buckets[b];
+          char* p = le;
+          memcpy(p, "le=\"", 4);
+          p = FastUInt64ToBufferLeft(Histogram::BucketUpperBound(b), p + 4);
+          *p++ = '"';
+          AppendSeries(out, entry.name, "_bucket", entry.labels,
+                       StringPiece(le, p - le));
+          AppendUInt(out, cumulative);
+          out->push_back('\n');
+        }
+        AppendSeries(out, entry.name, "_bucket", entry.labels, "le=\"+Inf\"");
+        AppendUInt(out, snapshot.count);
+        out->push_back('\n');
+        AppendSeries(out, entry.name, "_sum", entry.labels, "");
+        AppendUInt(out, snapshot.sum);
+        out->push_back('\n');
+        AppendSeries(out, entry.name, "_count", entry.labels, "");
+        AppendUInt(out, snapshot.count);
+        out->push_back('\n');
+        break;
+      }
+    }
+  }
+}
+
+}  // namespace metrics
+}  // namespace foundation
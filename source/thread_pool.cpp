@@ -0,0 +1,233 @@
+#include <foundation/base/thread_pool.hpp>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace foundation {
+
+namespace {
+
+// Which pool, if any, the current thread works for.
+struct CurrentWorkerInfo {
+  const void* pool;
+  size_t index;
+};
+
+thread_local CurrentWorkerInfo t_current = { NULL, 0 };
+
+// Rounds of yield-and-retry before a worker with nothing to do parks.
+const int kSpinRounds = 32;
+
+inline uint64_t NextRandom(uint64_t* state)
+{
+  // xorshift64*; only used to pick steal victims.
+  uint64_t x = *state;
+  x ^= x >> 12;
+  x ^= x << 25;
+  x ^= x >> 27;
+  *state = x;
+  return x * 0x2545F4914F6CDD1DULL;
+}
+
+void PinThread(std::thread& thread, int cpu)
+{
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+#else
+  (void)thread;
+  (void)cpu;
+#endif
+}
+
+}  // namespace
+
+struct ThreadPool::Worker {
+  WorkStealingDeque<Task> deque;
+  std::thread thread;
+};
+
+ThreadPool::ThreadPool(size_t threads)
+  : injected_(0),
+    sleepers_(0),
+    wake_epoch_(0),
+    stopping_(false)
+{
+  Options options;
+  options.threads = threads;
+  Start(options);
+}
+
+ThreadPool::ThreadPool(const Options& options)
+  : injected_(0),
+    sleepers_(0),
+    wake_epoch_(0),
+    stopping_(false)
+{
+  Start(options);
+}
+
+void ThreadPool::Start(const Options& options)
+{
+  size_t threads = options.threads;
+  if (threads == 0) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  // Every worker exists before any thread starts, since thieves index
+  // workers_ freely.
+  workers_.reserve(threads);
+  for (size_t i = 0; i < threads; ++i) {
+    workers_.emplace_back(new Worker);
+  }
+  const unsigned cpus = std::max(1u, std::thread::hardware_concurrency());
+  for (size_t i = 0; i < threads; ++i) {
+    std::thread& thread = workers_[i]->thread;
+    thread = std::thread(&ThreadPool::WorkerLoop, this, i);
+    if (!options.cpus.empty()) {
+      PinThread(thread, options.cpus[i % options.cpus.size()]);
+    } else if (options.pin_threads) {
+      PinThread(thread, static_cast<int>(i % cpus));
+    }
+  }
+}
+
+ThreadPool::~ThreadPool()
+{
+  stopping_.store(true);
+  {
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+    ++wake_epoch_;
+  }
+  wake_.notify_all();
+  for (size_t i = 0; i < workers_.size(); ++i) {
+    workers_[i]->thread.join();
+  }
+}
+
+int ThreadPool::CurrentWorker() const
+{
+  return t_current.pool == this ? static_cast<int>(t_current.index) : -1;
+}
+
+void ThreadPool::Schedule(std::function<void()> fn)
+{
+  Task* task = new Task(std::move(fn));
+  if (t_current.pool == this) {
+    workers_[t_current.index]->deque.Push(task);
+  } else {
+    std::lock_guard<std::mutex> lock(injection_mutex_);
+    injection_.push_back(task);
+    injected_.fetch_add(1);
+  }
+  WakeOne();
+}
+
+void ThreadPool::WakeOne()
+{
+  // Pairs with the sleepers_ increment in WorkerLoop: either this load
+  // sees the sleeper, or the sleeper's last look for work sees the task.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (sleepers_.load() == 0) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+    ++wake_epoch_;
+  }
+  wake_.notify_one();
+}
+
+ThreadPool::Task* ThreadPool::FindTask(size_t index, uint64_t* rng)
+{
+  if (Task* task = workers_[index]->deque.Pop()) {
+    return task;
+  }
+  if (injected_.load() > 0) {
+    std::lock_guard<std::mutex> lock(injection_mutex_);
+    if (!injection_.empty()) {
+      Task* task = injection_.front();
+      injection_.pop_front();
+      injected_.fetch_sub(1);
+      return task;
+    }
+  }
+  return StealTask(index, rng);
+}
+
+ThreadPool::Task* ThreadPool::StealTask(size_t index, uint64_t* rng)
+{
+  const size_t n = workers_.size();
+  const size_t start = static_cast<size_t>(NextRandom(rng) % n);
+  for (size_t i = 0; i < n; ++i) {
+    const size_t victim = (start + i) % n;
+    if (victim == index) {
+      continue;
+    }
+    if (Task* task = workers_[victim]->deque.Steal()) {
+      return task;
+    }
+  }
+  return NULL;
+}
+
+void ThreadPool::WorkerLoop(size_t index)
+{
+  t_current.pool = this;
+  t_current.index = index;
+  uint64_t rng = 0x9E3779B97F4A7C15ULL * (index + 1);
+
+  for (;;) {
+    Task* task = FindTask(index, &rng);
+    for (int spin = 0; task == NULL && spin < kSpinRounds; ++spin) {
+      std::this_thread::yield();
+      task = FindTask(index, &rng);
+    }
+
+    if (task == NULL) {
+      uint64_t epoch;
+      {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        epoch = wake_epoch_;
+      }
+      sleepers_.fetch_add(1);
+      task = FindTask(index, &rng);
+      if (task == NULL) {
+        if (stopping_.load()) {
+          // Nothing is queued anywhere this worker can reach; tasks still
+          // running elsewhere drain their own deques before exiting.
+          sleepers_.fetch_sub(1);
+          return;
+        }
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        wake_.wait(lock, [&] {
+          return wake_epoch_ != epoch || stopping_.load();
+        });
+      }
+      sleepers_.fetch_sub(1);
+      if (task == NULL) {
+        continue;
+      }
+    }
+
+    try {
+      (*task)();
+    } catch (...) {
+      // Schedule() documents that exceptions are dropped.
+    }
+    delete task;
+  }
+}
+
+ThreadPool* ThreadPool::Default()
+{
+  // Leaked so that tasks running during static destruction still have
+  // their pool.
+  static ThreadPool* pool = new ThreadPool();
+  return pool;
+}
+
+}  // namespace foundation
@@ -0,0 +1,23 @@
+
+#include <foundation/datetime/timeHelpers.hpp>
+
+
+namespace Foundation
+{
+
+time_t now()
+{
+  return time( NULL );
+}
+
+float calcDiff( time_t b, time_t a )
+{
+  return static_cast<float>( difftime( a, b ) );
+}
+
+time_t addDelay( time_t start, float delay )
+{
+  return start + static_cast<time_t>( delay );
+}
+
+}
@@ -1,37 +1,253 @@
 
 #include <foundation/datetime/timer.hpp>
-#include <foundation/datetime/timeHelpers.hpp>
+#include <foundation/base/trace.hpp>
 
+#include <algorithm>
+#include <memory>
 #include <mutex>
+#include <unordered_map>
 #include <vector>
 
 
-struct Timer
+namespace {
+
+void FireTimer( TimerWait* wait );
+
+// A timer added through AddTimer(), scheduled as a TimerWait.
+struct Timer : TimerWait
 {
+  Timer()
+    : TimerWait( &FireTimer ),
+      stopped( false )
+  {}
+
   uuid id;
-  time_t startAt;
-  float delay;
+  TimerClock::duration period;
   TimerType flag;
   std::function<void () > callback;
+  bool stopped;  //< StopTimer() was called while the callback ran.
 };
 
+}
+
 bool running;
 std::mutex mutex;
-std::vector<Timer > s_instances;
+
+// Scheduled TimerWaits, as a binary min-heap on deadline.  Each wait
+// records its position so that it can be cancelled in O(log n).
+std::vector<TimerWait* > s_waits;
+uint64_t s_sequence = 0;
+
+// Due waits that UpdateTimers() has taken off the heap because they were
+// scheduled after it began.  It puts them back when it finishes.
+std::vector<TimerWait* > s_deferred;
+
+// Timers from AddTimer() that are scheduled or firing.
+std::unordered_map<uuid, std::unique_ptr<Timer > > s_timers;
+
+std::vector<TimerObserver* > s_observers;
+
+namespace {
+
+// heapIndex of a wait in s_deferred.
+const size_t kDeferred = TimerWait::kNotScheduled - 1;
+
+bool Earlier( const TimerWait* a, const TimerWait* b )
+{
+  return a->deadline < b->deadline;
+}
+
+void Place( TimerWait* wait, size_t i )
+{
+  s_waits[i] = wait;
+  wait->heapIndex = i;
+}
+
+void SiftUp( size_t i )
+{
+  TimerWait* wait = s_waits[i];
+  while ( i > 0 && Earlier( wait, s_waits[( i - 1 ) / 2] ) )
+  {
+    Place( s_waits[( i - 1 ) / 2], i );
+    i = ( i - 1 ) / 2;
+  }
+  Place( wait, i );
+}
+
+void SiftDown( size_t i )
+{
+  TimerWait* wait = s_waits[i];
+  const size_t n = s_waits.size();
+  for ( ;; )
+  {
+    size_t child = 2 * i + 1;
+    if ( child >= n )
+    {
+      break;
+    }
+    if ( child + 1 < n && Earlier( s_waits[child + 1], s_waits[child] ) )
+    {
+      ++child;
+    }
+    if ( !Earlier( s_waits[child], wait ) )
+    {
+      break;
+    }
+    Place( s_waits[child], i );
+    i = child;
+  }
+  Place( wait, i );
+}
+
+// The following require the lock.
+
+void Schedule( TimerWait* wait, TimerClock::time_point deadline )
+{
+  wait->deadline = deadline;
+  wait->sequence = ++s_sequence;
+  s_waits.push_back( wait );
+  SiftUp( s_waits.size() - 1 );
+  if ( wait->heapIndex == 0 )
+  {
+    for ( TimerObserver* observer : s_observers )
+    {
+      observer->earlier( observer );
+    }
+  }
+}
+
+// Takes the wait at position i out of the heap.
+void RemoveAt( size_t i )
+{
+  TimerWait* removed = s_waits[i];
+  TimerWait* last = s_waits.back();
+  s_waits.pop_back();
+  removed->heapIndex = TimerWait::kNotScheduled;
+  if ( i < s_waits.size() )
+  {
+    Place( last, i );
+    SiftDown( i );
+    SiftUp( last->heapIndex );
+  }
+}
+
+// Takes a scheduled wait out of the heap or s_deferred.
+void Unschedule( TimerWait* wait )
+{
+  if ( wait->heapIndex == kDeferred )
+  {
+    s_deferred.erase( std::find( s_deferred.begin(), s_deferred.end(), wait ) );
+    wait->heapIndex = TimerWait::kNotScheduled;
+  }
+  else
+  {
+    RemoveAt( wait->heapIndex );
+  }
+}
+
+void FireTimer( TimerWait* wait )
+{
+  Timer* timer = static_cast<Timer* >( wait );
+  timer->callback();
+
+  std::lock_guard<std::mutex> lock(mutex);
+  if ( timer->flag == TimerType::CYCLE && !timer->stopped )
+  {
+    // Keep to the original cadence, unless it has fallen a whole period
+    // behind; then skip the missed ticks rather than firing in a burst.
+    const TimerClock::time_point now = TimerClock::now();
+    TimerClock::time_point next = timer->deadline + timer->period;
+    if ( next < now )
+    {
+      next = now + timer->period;
+    }
+    Schedule( timer, next );
+  }
+  else
+  {
+    s_timers.erase( timer->id );
+  }
+}
+
+}
 
 uuid AddTimer( float delay, TimerType flag, std::function<void () > callback )
 {
-  uuid id = getUuid();
-  time_t now = Foundation::now();
+  std::unique_ptr<Timer > timer( new Timer() );
+  timer->id = getUuid();
+  timer->period = std::chrono::duration_cast<TimerClock::duration>(
+      std::chrono::duration<float>( std::max( delay, 0.0f ) ) );
+  timer->flag = flag;
+  timer->callback = std::move( callback );
+
+  const uuid id = timer->id;
+  const TimerClock::time_point deadline = TimerClock::now() + timer->period;
   std::lock_guard<std::mutex> lock(mutex);
-  s_instances.push_back( { id, now, delay, flag, callback } );
-  //@todo: Sort list based upon expiry time.
+  Schedule( timer.get(), deadline );
+  s_timers[id] = std::move( timer );
   return id;
 }
 
 void StopTimer( uuid handle )
 {
-  //@todo: do something!
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = s_timers.find( handle );
+  if ( it == s_timers.end() )
+  {
+    return;
+  }
+  Timer* timer = it->second.get();
+  if ( timer->heapIndex != TimerWait::kNotScheduled )
+  {
+    Unschedule( timer );
+    s_timers.erase( it );
+  }
+  else
+  {
+    // Its callback is running; FireTimer() cleans up afterwards.
+    timer->stopped = true;
+  }
+}
+
+void ScheduleTimerWait( TimerWait* wait, TimerClock::time_point deadline )
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  Schedule( wait, deadline );
+}
+
+bool CancelTimerWait( TimerWait* wait )
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  if ( wait->heapIndex == TimerWait::kNotScheduled )
+  {
+    return false;
+  }
+  Unschedule( wait );
+  return true;
+}
+
+bool NextTimerDeadline( TimerClock::time_point* deadline )
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  if ( s_waits.empty() )
+  {
+    return false;
+  }
+  *deadline = s_waits.front()->deadline;
+  return true;
+}
+
+void AddTimerObserver( TimerObserver* observer )
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  s_observers.push_back( observer );
+}
+
+void RemoveTimerObserver( TimerObserver* observer )
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  s_observers.erase( std::remove( s_observers.begin(), s_observers.end(), observer ),
+                     s_observers.end() );
 }
 
 void TimerThread()
@@ -44,24 +260,50 @@ void TimerThread()
 
 void UpdateTimers()
 {
-  // Get the current time.
-  time_t now = Foundation::now();
+  TRACE_SCOPE( "timer", "UpdateTimers" );
 
-  // Iterate all the timers until you get one that will expire past the current
-  // time
-  for ( Timer& t : s_instances )
+  // Fire due waits one at a time, without the lock, so that a callback
+  // can schedule or cancel waits.  Waits scheduled once the update has
+  // begun wait for the next one, so that a timer that keeps rescheduling
+  // itself for the past cannot keep this from returning.  Such a wait
+  // can sort ahead of older ones that are due, so it is set aside in
+  // s_deferred rather than ending the update.
+  const TimerClock::time_point now = TimerClock::now();
+  uint64_t last;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    last = s_sequence;
+  }
+  for ( ;; )
   {
-    float dt = Foundation::calcDiff( now, Foundation::addDelay( t.startAt, t.delay ) );
-    if ( dt < 0 )
+    TimerWait* due = nullptr;
     {
-      t.callback(); //< invoke callback.
+      std::lock_guard<std::mutex> lock(mutex);
+      while ( !s_waits.empty() && s_waits.front()->deadline <= now )
+      {
+        TimerWait* front = s_waits.front();
+        RemoveAt( 0 );
+        if ( front->sequence <= last )
+        {
+          due = front;
+          break;
+        }
+        front->heapIndex = kDeferred;
+        s_deferred.push_back( front );
+      }
     }
-    else
+    if ( due == nullptr )
     {
-      //@todo: add a delay?
-      continue;
+      break;
     }
+    TRACE_SCOPE( "timer", "TimerCallback" );
+    due->fire( due );
   }
 
-  //@todo: remove used timers.
+  std::lock_guard<std::mutex> lock(mutex);
+  for ( TimerWait* wait : s_deferred )
+  {
+    Schedule( wait, wait->deadline );
+  }
+  s_deferred.clear();
 }
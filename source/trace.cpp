@@ -0,0 +1,263 @@
+
+#include <foundation/base/trace.hpp>
+
+#include <foundation/strings/numbers.hpp>
+
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+#if FOUNDATION_TRACING && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define TRACE_HAVE_TSC 1
+#endif
+
+namespace foundation {
+namespace trace {
+
+#if FOUNDATION_TRACING
+
+namespace internal {
+
+std::atomic<bool> g_enabled(false);
+
+}  // namespace internal
+
+namespace {
+
+// Instants are stored with this duration.
+const uint64_t kInstant = ~uint64_t(0);
+
+// Every field is an atomic so that an export racing with the writer
+// reads stale or fresh values, never undefined ones; relaxed accesses
+// compile to plain moves.
+struct Event {
+  std::atomic<const char*> category;
+  std::atomic<const char*> name;
+  std::atomic<uint64_t> begin;
+  std::atomic<uint64_t> duration;
+};
+
+struct ThreadBuffer {
+  explicit ThreadBuffer(uint32_t tid) : tid(tid), head(0), cleared(0) {}
+
+  const uint32_t tid;
+  std::atomic<uint64_t> head;     // Events ever written; owner writes.
+  std::atomic<uint64_t> cleared;  // Events before this were Clear()ed.
+  Event events[kEventsPerThread];
+};
+
+// Buffers are never freed, so that events from exited threads can still
+// be exported.  One buffer per thread that ever traced.
+std::mutex g_registry_mutex;
+std::vector<ThreadBuffer*> g_registry;
+
+// Maps timestamps to nanoseconds, fixed by the first Start().
+std::once_flag g_calibrate_once;
+uint64_t g_base_ticks = 0;
+double g_ticks_per_ns = 1.0;
+
+ThreadBuffer* CreateThreadBuffer() {
+  std::lock_guard<std::mutex> lock(g_registry_mutex);
+  ThreadBuffer* buffer =
+      new ThreadBuffer(static_cast<uint32_t>(g_registry.size() + 1));
+  g_registry.push_back(buffer);
+  return buffer;
+}
+
+inline ThreadBuffer* CurrentThreadBuffer() {
+  static thread_local ThreadBuffer* buffer = NULL;
+  if (buffer == NULL) buffer = CreateThreadBuffer();
+  return buffer;
+}
+
+inline void Record(const char* category, const char* name, uint64_t begin,
+                   uint64_t duration) {
+  ThreadBuffer* buffer = CurrentThreadBuffer();
+  const uint64_t index = buffer->head.load(std::memory_order_relaxed);
+  Event& event = buffer->events[index & (kEventsPerThread - 1)];
+  event.category.store(category, std::memory_order_relaxed);
+  event.name.store(name, std::memory_order_relaxed);
+  event.begin.store(begin, std::memory_order_relaxed);
+  event.duration.store(duration, std::memory_order_relaxed);
+  buffer->head.store(index + 1, std::memory_order_release);
+}
+
+uint64_t SteadyNanos() {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void Calibrate() {
+  g_base_ticks = internal::Now();
+#ifdef TRACE_HAVE_TSC
+  // Assumes an invariant TSC, as on any x86 of the last decade.
+  const uint64_t ns0 = SteadyNanos();
+  const uint64_t ticks0 = __rdtsc();
+  uint64_t ns1;
+  do {
+    ns1 = SteadyNanos();
+  } while (ns1 - ns0 < 2000000);
+  const uint64_t ticks1 = __rdtsc();
+  g_ticks_per_ns = static_cast<double>(ticks1 - ticks0) /
+                   static_cast<double>(ns1 - ns0);
+#endif
+}
+
+void AppendJsonString(std::string* out, const char* s) {
+  out->push_back('"');
+  for (; *s != '\0'; ++s) {
+    const unsigned char c = static_cast<unsigned char>(*s);
+    if (c == '"' || c == '\\') {
+      out->push_back('\\');
+      out->push_back(static_cast<char>(c));
+    } else if (c < 0x20) {
+      static const char kHex[] = "0123456789abcdef";
+      out->append("\\u00");
+      out->push_back(kHex[c >> 4]);
+      out->push_back(kHex[c & 15]);
+    } else {
+      out->push_back(static_cast<char>(c));
+    }
+  }
+  out->push_back('"');
+}
+
+void AppendUInt(std::string* out, uint64_t value) {
+  char buffer[24];
+  out->append(buffer, FastUInt64ToBufferLeft(value, buffer));
+}
+
+// Microseconds with nanosecond precision, the unit Chrome expects.
+void AppendMicros(std::string* out, uint64_t ns) {
+  AppendUInt(out, ns / 1000);
+  char fraction[4] = {'.', static_cast<char>('0' + ns / 100 % 10),
+                      static_cast<char>('0' + ns / 10 % 10),
+                      static_cast<char>('0' + ns % 10)};
+  out->append(fraction, 4);
+}
+
+uint64_t TicksToNanos(uint64_t ticks) {
+  if (ticks < g_base_ticks) return 0;
+  return static_cast<uint64_t>(static_cast<double>(ticks - g_base_ticks) /
+                               g_ticks_per_ns);
+}
+
+}  // namespace
+
+namespace internal {
+
+uint64_t Now() {
+#ifdef TRACE_HAVE_TSC
+  return __rdtsc();
+#else
+  return SteadyNanos();
+#endif
+}
+
+void RecordSpan(const char* category, const char* name, uint64_t begin,
+                uint64_t end) {
+  Record(category, name, begin, end - begin);
+}
+
+void RecordInstant(const char* category, const char* name) {
+  Record(category, name, Now(), kInstant);
+}
+
+}  // namespace internal
+
+void Start() {
+  std::call_once(g_calibrate_once, Calibrate);
+  internal::g_enabled.store(true);
+}
+
+void Stop() {
+  internal::g_enabled.store(false);
+}
+
+void Clear() {
+  std::lock_guard<std::mutex> lock(g_registry_mutex);
+  for (size_t i = 0; i < g_registry.size(); ++i) {
+    g_registry[i]->cleared.store(g_registry[i]->head.load());
+  }
+}
+
+void WriteChromeJson(std::string* out) {
+  std::vector<ThreadBuffer*> buffers;
+  {
+    std::lock_guard<std::mutex> lock(g_registry_mutex);
+    buffers = g_registry;
+  }
+
+  out->append("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+  bool first = true;
+  for (size_t b = 0; b < buffers.size(); ++b) {
+    ThreadBuffer* buffer = buffers[b];
+    const uint64_t head = buffer->head.load(std::memory_order_acquire);
+    uint64_t begin = buffer->cleared.load();
+    if (head - begin > kEventsPerThread) begin = head - kEventsPerThread;
+
+    std::string events;
+    for (uint64_t i = begin; i < head; ++i) {
+      const Event& event = buffer->events[i & (kEventsPerThread - 1)];
+      const char* category = event.category.load(std::memory_order_relaxed);
+      const char* name = event.name.load(std::memory_order_relaxed);
+      const uint64_t start = event.begin.load(std::memory_order_relaxed);
+      const uint64_t duration = event.duration.load(std::memory_order_relaxed);
+      // Skip the event if the writer lapped it while we were reading.
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (buffer->head.load(std::memory_order_relaxed) - i >=
+          kEventsPerThread) {
+        continue;
+      }
+
+      events.append(events.empty() ? "\n{\"name\":" : ",\n{\"name\":");
+      AppendJsonString(&events, name);
+      events.append(",\"cat\":");
+      AppendJsonString(&events, category);
+      if (duration == kInstant) {
+        events.append(",\"ph\":\"i\",\"s\":\"t\",\"ts\":");
+        AppendMicros(&events, TicksToNanos(start));
+      } else {
+        events.append(",\"ph\":\"X\",\"ts\":");
+        AppendMicros(&events, TicksToNanos(start));
+        events.append(",\"dur\":");
+        AppendMicros(&events,
+                     static_cast<uint64_t>(duration / g_ticks_per_ns));
+      }
+      events.append(",\"pid\":1,\"tid\":");
+      AppendUInt(&events, buffer->tid);
+      events.push_back('}');
+    }
+
+    // A name for the thread's track.
+    out->append(first ? "\n" : ",\n");
+    first = false;
+    out->append("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":");
+    AppendUInt(out, buffer->tid);
+    out->append(",\"args\":{\"name\":\"thread ");
+    AppendUInt(out, buffer->tid);
+    out->append("\"}}");
+    if (!events.empty()) {
+      out->push_back(',');
+      out->append(events);
+    }
+  }
+  out->append("\n]}\n");
+}
+
+#else  // !FOUNDATION_TRACING
+
+void Start() {}
+void Stop() {}
+void Clear() {}
+
+void WriteChromeJson(std::string* out) {
+  out->append("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[]}\n");
+}
+
+#endif  // FOUNDATION_TRACING
+
+}  // namespace trace
+}  // namespace foundation
@@ -0,0 +1,591 @@
+#include <foundation/strings/utf8.hpp>
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define UTF8_HAVE_X86_SIMD 1
+#endif
+
+namespace foundation {
+
+namespace {
+
+inline bool IsContinuation(uint8_t b) { return (b & 0xC0) == 0x80; }
+
+inline bool IsSurrogate(uint32_t c) { return (c & 0xFFFFF800) == 0xD800; }
+
+// ----------------------------------------------------------------------
+// Scalar decoding and encoding
+// ----------------------------------------------------------------------
+
+// Decodes the sequence at p, which starts with a byte >= 0x80.  Returns
+// its length, or 0 if it is ill-formed or runs past end.  The ranges are
+// those of Unicode Table 3-7.
+inline int DecodeMultiByte(const uint8_t* p, const uint8_t* end,
+                           uint32_t* c) {
+  const uint8_t b0 = p[0];
+  const size_t avail = end - p;
+  if (b0 < 0xC2) {
+    return 0;  // A continuation byte, or an overlong 2-byte lead.
+  }
+  if (b0 < 0xE0) {
+    if (avail < 2 || !IsContinuation(p[1])) return 0;
+    *c = (uint32_t(b0 & 0x1F) << 6) | (p[1] & 0x3F);
+    return 2;
+  }
+  if (b0 < 0xF0) {
+    // E0 must be followed by A0..BF (else overlong), ED by 80..9F (else
+    // a surrogate).
+    const uint8_t lo = b0 == 0xE0 ? 0xA0 : 0x80;
+    const uint8_t hi = b0 == 0xED ? 0x9F : 0xBF;
+    if (avail < 3 || p[1] < lo || p[1] > hi || !IsContinuation(p[2])) {
+      return 0;
+    }
+    *c = (uint32_t(b0 & 0x0F) << 12) | (uint32_t(p[1] & 0x3F) << 6) |
+         (p[2] & 0x3F);
+    return 3;
+  }
+  if (b0 < 0xF5) {
+    // F0 must be followed by 90..BF (else overlong), F4 by 80..8F (else
+    // above U+10FFFF).
+    const uint8_t lo = b0 == 0xF0 ? 0x90 : 0x80;
+    const uint8_t hi = b0 == 0xF4 ? 0x8F : 0xBF;
+    if (avail < 4 || p[1] < lo || p[1] > hi || !IsContinuation(p[2]) ||
+        !IsContinuation(p[3])) {
+      return 0;
+    }
+    *c = (uint32_t(b0 & 0x07) << 18) | (uint32_t(p[1] & 0x3F) << 12) |
+         (uint32_t(p[2] & 0x3F) << 6) | (p[3] & 0x3F);
+    return 4;
+  }
+  return 0;
+}
+
+// c must be a Unicode scalar value.
+inline char* EncodeUtf8(uint32_t c, char* out) {
+  if (c < 0x80) {
+    *out++ = static_cast<char>(c);
+  } else if (c < 0x800) {
+    *out++ = static_cast<char>(0xC0 | (c >> 6));
+    *out++ = static_cast<char>(0x80 | (c & 0x3F));
+  } else if (c < 0x10000) {
+    *out++ = static_cast<char>(0xE0 | (c >> 12));
+    *out++ = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+    *out++ = static_cast<char>(0x80 | (c & 0x3F));
+  } else {
+    *out++ = static_cast<char>(0xF0 | (c >> 18));
+    *out++ = static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+    *out++ = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+    *out++ = static_cast<char>(0x80 | (c & 0x3F));
+  }
+  return out;
+}
+
+// ----------------------------------------------------------------------
+// Validation
+//
+// The scalar validator skips ASCII a word at a time and decodes the
+// rest.  The vector kernels check a block at a time and, when a block
+// fails, hand over to the scalar validator from the start of the
+// character the block begins in, so that every path reports the same
+// error offset.
+// ----------------------------------------------------------------------
+
+typedef size_t (*ValidateFn)(const uint8_t* p, size_t n);
+
+size_t ValidateScalar(const uint8_t* p, size_t n) {
+  const uint8_t* const end = p + n;
+  size_t i = 0;
+  while (i < n) {
+    if (i + 8 <= n) {
+      uint64_t word;
+      memcpy(&word, p + i, 8);
+      if ((word & 0x8080808080808080ULL) == 0) {
+        i += 8;
+        continue;
+      }
+    }
+    if (p[i] < 0x80) {
+      ++i;
+      continue;
+    }
+    uint32_t c;
+    const int length = DecodeMultiByte(p + i, end, &c);
+    if (length == 0) return i;
+    i += length;
+  }
+  return n;
+}
+
+// Where to resume scalar validation when the blocks before offset i have
+// passed: the start of the character holding byte i - 1, which may still
+// be waiting for continuation bytes at i and beyond.
+inline size_t CharacterStartBefore(const uint8_t* p, size_t i) {
+  if (i == 0) return 0;
+  size_t start = i - 1;
+  while (start > 0 && i - start < 4 && IsContinuation(p[start])) --start;
+  return start;
+}
+
+inline size_t FinishScalar(const uint8_t* p, size_t n, size_t i) {
+  const size_t start = CharacterStartBefore(p, i);
+  return start + ValidateScalar(p + start, n - start);
+}
+
+// True if a block ending just before p + i (i >= 3) leaves a multi-byte
+// sequence unfinished.
+inline bool EndsIncomplete(const uint8_t* p, size_t i) {
+  return p[i - 1] >= 0xC0 || p[i - 2] >= 0xE0 || p[i - 3] >= 0xF0;
+}
+
+#ifdef UTF8_HAVE_X86_SIMD
+
+// Lookup tables for the Keiser-Lemire check.  Each classifies a pair of
+// adjacent bytes (prev, cur) by one nibble: the high and low nibble of
+// prev and the high nibble of cur.  The three results are ANDed, so a
+// bit survives only for an error all three nibbles agree on.
+//
+// TWO_CONTS is not an error by itself: a continuation after a
+// continuation is required in the third and fourth bytes of a sequence,
+// and the caller XORs it against that requirement.
+enum {
+  TOO_SHORT = 1 << 0,   // Lead byte not followed by a continuation.
+  TOO_LONG = 1 << 1,    // Continuation byte after ASCII.
+  OVERLONG_3 = 1 << 2,  // E0 80..9F
+  TOO_LARGE = 1 << 3,   // F4 90..BF, F5..FF
+  SURROGATE = 1 << 4,   // ED A0..BF
+  OVERLONG_2 = 1 << 5,  // C0, C1
+  TOO_LARGE_1000 = 1 << 6,
+  OVERLONG_4 = 1 << 6,  // F0 80..8F
+  TWO_CONTS = 1 << 7,
+  CARRY = TOO_SHORT | TOO_LONG | TWO_CONTS,  // Decided by the high nibble.
+};
+
+alignas(16) const int8_t kPrevHighNibble[16] = {
+    // 0_______: ASCII.
+    TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+    TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+    // 10______: continuation.
+    int8_t(TWO_CONTS), int8_t(TWO_CONTS), int8_t(TWO_CONTS),
+    int8_t(TWO_CONTS),
+    // 1100____, 1101____: 2-byte lead.
+    TOO_SHORT | OVERLONG_2,
+    TOO_SHORT,
+    // 1110____: 3-byte lead.
+    TOO_SHORT | OVERLONG_3 | SURROGATE,
+    // 1111____: 4-byte lead or worse.
+    TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4,
+};
+
+alignas(16) const int8_t kPrevLowNibble[16] = {
+    int8_t(CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4),  // ____0000
+    int8_t(CARRY | OVERLONG_2),                            // ____0001
+    int8_t(CARRY),
+    int8_t(CARRY),
+    int8_t(CARRY | TOO_LARGE),                             // ____0100
+    int8_t(CARRY | TOO_LARGE | TOO_LARGE_1000),            // ____0101
+    int8_t(CARRY | TOO_LARGE | TOO_LARGE_1000),
+    int8_t(CARRY | TOO_LARGE | TOO_LARGE_1000),
+    int8_t(CARRY | TOO_LARGE | TOO_LARGE_1000),
+    int8_t(CARRY | TOO_LARGE | TOO_LARGE_1000),
+    int8_t(CARRY | TOO_LARGE | TOO_LARGE_1000),
+    int8_t(CARRY | TOO_LARGE | TOO_LARGE_1000),
+    int8_t(CARRY | TOO_LARGE | TOO_LARGE_1000),
+    int8_t(CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE),  // ____1101
+    int8_t(CARRY | TOO_LARGE | TOO_LARGE_1000),
+    int8_t(CARRY | TOO_LARGE | TOO_LARGE_1000),
+};
+
+alignas(16) const int8_t kCurHighNibble[16] = {
+    // 0_______: ASCII.
+    TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+    TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+    // 1000____
+    int8_t(TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 |
+           OVERLONG_4),
+    // 1001____
+    int8_t(TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE),
+    // 101_____
+    int8_t(TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE),
+    int8_t(TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE),
+    // 11______: a lead byte.
+    TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+};
+
+__attribute__((target("ssse3")))
+inline __m128i LoadTable16(const int8_t* table) {
+  return _mm_load_si128(reinterpret_cast<const __m128i*>(table));
+}
+
+// Non-zero bytes where the block in, preceded by prev, is ill-formed.
+__attribute__((target("ssse3")))
+inline __m128i CheckBlockSsse3(__m128i in, __m128i prev) {
+  const __m128i nibble = _mm_set1_epi8(0x0F);
+  const __m128i prev1 = _mm_alignr_epi8(in, prev, 15);
+  const __m128i prev2 = _mm_alignr_epi8(in, prev, 14);
+  const __m128i prev3 = _mm_alignr_epi8(in, prev, 13);
+  const __m128i special = _mm_and_si128(
+      _mm_and_si128(
+          _mm_shuffle_epi8(LoadTable16(kPrevHighNibble),
+                           _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble)),
+          _mm_shuffle_epi8(LoadTable16(kPrevLowNibble),
+                           _mm_and_si128(prev1, nibble))),
+      _mm_shuffle_epi8(LoadTable16(kCurHighNibble),
+                       _mm_and_si128(_mm_srli_epi16(in, 4), nibble)));
+  // Bit 7 where this byte must be the third or fourth of a sequence.
+  const __m128i must_be_continuation = _mm_and_si128(
+      _mm_or_si128(_mm_subs_epu8(prev2, _mm_set1_epi8(0xE0 - 0x80)),
+                   _mm_subs_epu8(prev3, _mm_set1_epi8(0xF0 - 0x80))),
+      _mm_set1_epi8(-128));
+  return _mm_xor_si128(must_be_continuation, special);
+}
+
+__attribute__((target("ssse3")))
+size_t ValidateSsse3(const uint8_t* p, size_t n) {
+  const __m128i zero = _mm_setzero_si128();
+  __m128i prev = zero;
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    const __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+    if (_mm_movemask_epi8(in) == 0) {
+      // All ASCII: fine unless the last block left a sequence open.
+      if (i != 0 && EndsIncomplete(p, i)) break;
+    } else if (_mm_movemask_epi8(_mm_cmpeq_epi8(CheckBlockSsse3(in, prev),
+                                                zero)) != 0xFFFF) {
+      break;
+    }
+    prev = in;
+  }
+  return FinishScalar(p, n, i);
+}
+
+__attribute__((target("avx2")))
+inline __m256i LoadTable32(const int8_t* table) {
+  return _mm256_broadcastsi128_si256(
+      _mm_load_si128(reinterpret_cast<const __m128i*>(table)));
+}
+
+__attribute__((target("avx2")))
+inline __m256i CheckBlockAvx2(__m256i in, __m256i prev) {
+  const __m256i nibble = _mm256_set1_epi8(0x0F);
+  // VPALIGNR shifts within 128-bit lanes, so pair each lane with the one
+  // before it: prev's high lane for in's low lane.
+  const __m256i before = _mm256_permute2x128_si256(prev, in, 0x21);
+  const __m256i prev1 = _mm256_alignr_epi8(in, before, 15);
+  const __m256i prev2 = _mm256_alignr_epi8(in, before, 14);
+  const __m256i prev3 = _mm256_alignr_epi8(in, before, 13);
+  const __m256i special = _mm256_and_si256(
+      _mm256_and_si256(
+          _mm256_shuffle_epi8(
+              LoadTable32(kPrevHighNibble),
+              _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble)),
+          _mm256_shuffle_epi8(LoadTable32(kPrevLowNibble),
+                              _mm256_and_si256(prev1, nibble))),
+      _mm256_shuffle_epi8(LoadTable32(kCurHighNibble),
+                          _mm256_and_si256(_mm256_srli_epi16(in, 4), nibble)));
+  const __m256i must_be_continuation = _mm256_and_si256(
+      _mm256_or_si256(_mm256_subs_epu8(prev2, _mm256_set1_epi8(0xE0 - 0x80)),
+                      _mm256_subs_epu8(prev3, _mm256_set1_epi8(0xF0 - 0x80))),
+      _mm256_set1_epi8(-128));
+  return _mm256_xor_si256(must_be_continuation, special);
+}
+
+__attribute__((target("avx2")))
+size_t ValidateAvx2(const uint8_t* p, size_t n) {
+  __m256i prev = _mm256_setzero_si256();
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    const __m256i in =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+    if (_mm256_movemask_epi8(in) == 0) {
+      if (i != 0 && EndsIncomplete(p, i)) break;
+    } else {
+      const __m256i error = CheckBlockAvx2(in, prev);
+      if (!_mm256_testz_si256(error, error)) break;
+    }
+    prev = in;
+  }
+  return FinishScalar(p, n, i);
+}
+
+#endif  // UTF8_HAVE_X86_SIMD
+
+ValidateFn ResolveValidate() {
+#ifdef UTF8_HAVE_X86_SIMD
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) return ValidateAvx2;
+  if (__builtin_cpu_supports("ssse3")) return ValidateSsse3;
+#endif
+  return ValidateScalar;
+}
+
+inline size_t Validate(const uint8_t* p, size_t n) {
+  static const ValidateFn validate = ResolveValidate();
+  return validate(p, n);
+}
+
+// ----------------------------------------------------------------------
+// Counting
+//
+// Each step compares 16 bytes and subtracts the 0/-1 masks from per-byte
+// counters, which are widened with PSADBW before they can overflow.
+// ----------------------------------------------------------------------
+
+#if defined(__SSE2__)
+
+inline __m128i Load16(const uint8_t* p) {
+  return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+}
+
+inline size_t SumBytes(__m128i counters) {
+  const __m128i sums = _mm_sad_epu8(counters, _mm_setzero_si128());
+  return _mm_extract_epi16(sums, 0) + _mm_extract_epi16(sums, 4);
+}
+
+#endif  // __SSE2__
+
+// The number of bytes of p[0, n) that start a character, plus, if
+// count_four_byte_leads, the number that start a 4-byte one.
+size_t CountLeadBytes(const uint8_t* p, size_t n, bool count_four_byte_leads) {
+  size_t count = 0;
+  size_t i = 0;
+#if defined(__SSE2__)
+  // As signed bytes, continuation bytes are -128..-65 and 4-byte leads
+  // (and the invalid F8..FF) are -16..-1.
+  const __m128i last_continuation = _mm_set1_epi8(-65);
+  const __m128i high_nibble = _mm_set1_epi8(static_cast<char>(0xF0));
+  const __m128i four_byte_mask =
+      count_four_byte_leads ? high_nibble : _mm_setzero_si128();
+  while (i + 16 <= n) {
+    // Each counter gains at most 2 per block.
+    size_t blocks = (n - i) / 16;
+    if (blocks > 127) blocks = 127;
+    __m128i counters = _mm_setzero_si128();
+    for (; blocks > 0; --blocks, i += 16) {
+      const __m128i in = Load16(p + i);
+      counters = _mm_sub_epi8(counters, _mm_cmpgt_epi8(in, last_continuation));
+      counters = _mm_sub_epi8(
+          counters, _mm_cmpeq_epi8(_mm_and_si128(in, four_byte_mask),
+                                   high_nibble));
+    }
+    count += SumBytes(counters);
+  }
+#endif
+  for (; i < n; ++i) {
+    count += !IsContinuation(p[i]);
+    count += count_four_byte_leads && p[i] >= 0xF0;
+  }
+  return count;
+}
+
+}  // namespace
+
+bool IsValidUtf8(StringPiece s) {
+  return ValidUtf8Prefix(s) == static_cast<size_t>(s.size());
+}
+
+size_t ValidUtf8Prefix(StringPiece s) {
+  return Validate(reinterpret_cast<const uint8_t*>(s.data()), s.size());
+}
+
+size_t CountUtf8CodePoints(StringPiece s) {
+  return CountLeadBytes(reinterpret_cast<const uint8_t*>(s.data()), s.size(),
+                        false);
+}
+
+size_t Utf16LengthOfUtf8(StringPiece s) {
+  // Characters from 4-byte sequences need a surrogate pair.
+  return CountLeadBytes(reinterpret_cast<const uint8_t*>(s.data()), s.size(),
+                        true);
+}
+
+size_t Utf8LengthOfUtf16(const char16_t* s, size_t n) {
+  // A surrogate pair, 4 bytes, counts 2 per unit.
+  size_t length = n;
+  for (size_t i = 0; i < n; ++i) {
+    const uint32_t u = s[i];
+    length += (u >= 0x80) + (u >= 0x800) - IsSurrogate(u);
+  }
+  return length;
+}
+
+size_t Utf8LengthOfUtf32(const char32_t* s, size_t n) {
+  size_t length = n;
+  for (size_t i = 0; i < n; ++i) {
+    const uint32_t c = s[i];
+    length += (c >= 0x80) + (c >= 0x800) + (c >= 0x10000);
+  }
+  return length;
+}
+
+// ----------------------------------------------------------------------
+// Transcoding
+//
+// Each loop converts runs of ASCII 16 code units per step (widened or
+// narrowed with SSE2 unpacks and saturating packs) and decodes or encodes
+// everything else one character at a time.
+// ----------------------------------------------------------------------
+
+TranscodeResult Utf8ToUtf16(StringPiece s, char16_t* out) {
+  const uint8_t* const p = reinterpret_cast<const uint8_t*>(s.data());
+  const uint8_t* const end = p + s.size();
+  const size_t n = s.size();
+  size_t i = 0;
+  size_t w = 0;
+  while (i < n) {
+#if defined(__SSE2__)
+    if (i + 16 <= n) {
+      const __m128i in = Load16(p + i);
+      if (_mm_movemask_epi8(in) == 0) {
+        const __m128i zero = _mm_setzero_si128();
+        __m128i* const dst = reinterpret_cast<__m128i*>(out + w);
+        _mm_storeu_si128(dst, _mm_unpacklo_epi8(in, zero));
+        _mm_storeu_si128(dst + 1, _mm_unpackhi_epi8(in, zero));
+        i += 16;
+        w += 16;
+        continue;
+      }
+    }
+#endif
+    if (p[i] < 0x80) {
+      out[w++] = p[i++];
+      continue;
+    }
+    uint32_t c;
+    const int length = DecodeMultiByte(p + i, end, &c);
+    if (length == 0) {
+      TranscodeResult result = {false, i, w};
+      return result;
+    }
+    i += length;
+    if (c < 0x10000) {
+      out[w++] = static_cast<char16_t>(c);
+    } else {
+      c -= 0x10000;
+      out[w++] = static_cast<char16_t>(0xD800 | (c >> 10));
+      out[w++] = static_cast<char16_t>(0xDC00 | (c & 0x3FF));
+    }
+  }
+  TranscodeResult result = {true, i, w};
+  return result;
+}
+
+TranscodeResult Utf8ToUtf32(StringPiece s, char32_t* out) {
+  const uint8_t* const p = reinterpret_cast<const uint8_t*>(s.data());
+  const uint8_t* const end = p + s.size();
+  const size_t n = s.size();
+  size_t i = 0;
+  size_t w = 0;
+  while (i < n) {
+#if defined(__SSE2__)
+    if (i + 16 <= n) {
+      const __m128i in = Load16(p + i);
+      if (_mm_movemask_epi8(in) == 0) {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i lo = _mm_unpacklo_epi8(in, zero);
+        const __m128i hi = _mm_unpackhi_epi8(in, zero);
+        __m128i* const dst = reinterpret_cast<__m128i*>(out + w);
+        _mm_storeu_si128(dst, _mm_unpacklo_epi16(lo, zero));
+        _mm_storeu_si128(dst + 1, _mm_unpackhi_epi16(lo, zero));
+        _mm_storeu_si128(dst + 2, _mm_unpacklo_epi16(hi, zero));
+        _mm_storeu_si128(dst + 3, _mm_unpackhi_epi16(hi, zero));
+        i += 16;
+        w += 16;
+        continue;
+      }
+    }
+#endif
+    if (p[i] < 0x80) {
+      out[w++] = p[i++];
+      continue;
+    }
+    uint32_t c;
+    const int length = DecodeMultiByte(p + i, end, &c);
+    if (length == 0) {
+      TranscodeResult result = {false, i, w};
+      return result;
+    }
+    i += length;
+    out[w++] = c;
+  }
+  TranscodeResult result = {true, i, w};
+  return result;
+}
+
+TranscodeResult Utf16ToUtf8(const char16_t* s, size_t n, char* out) {
+  char* w = out;
+  size_t i = 0;
+  while (i < n) {
+#if defined(__SSE2__)
+    if (i + 16 <= n) {
+      const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+      const __m128i b =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i + 8));
+      const __m128i high_bits = _mm_and_si128(
+          _mm_or_si128(a, b), _mm_set1_epi16(static_cast<short>(0xFF80)));
+      if (_mm_movemask_epi8(_mm_cmpeq_epi16(high_bits, _mm_setzero_si128())) ==
+          0xFFFF) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(w), _mm_packus_epi16(a, b));
+        i += 16;
+        w += 16;
+        continue;
+      }
+    }
+#endif
+    uint32_t c = s[i];
+    if (IsSurrogate(c)) {
+      // Only a high surrogate followed by a low one is allowed.
+      if (c >= 0xDC00 || i + 1 == n || (s[i + 1] & 0xFC00) != 0xDC00) {
+        TranscodeResult result = {false, i, static_cast<size_t>(w - out)};
+        return result;
+      }
+      c = 0x10000 + ((c - 0xD800) << 10) + (s[i + 1] - 0xDC00);
+      ++i;
+    }
+    ++i;
+    w = EncodeUtf8(c, w);
+  }
+  TranscodeResult result = {true, i, static_cast<size_t>(w - out)};
+  return result;
+}
+
+TranscodeResult Utf32ToUtf8(const char32_t* s, size_t n, char* out) {
+  char* w = out;
+  size_t i = 0;
+  while (i < n) {
+#if defined(__SSE2__)
+    if (i + 16 <= n) {
+      const __m128i* const src = reinterpret_cast<const __m128i*>(s + i);
+      const __m128i a = _mm_loadu_si128(src);
+      const __m128i b = _mm_loadu_si128(src + 1);
+      const __m128i c = _mm_loadu_si128(src + 2);
+      const __m128i d = _mm_loadu_si128(src + 3);
+      const __m128i high_bits =
+          _mm_and_si128(_mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d)),
+                        _mm_set1_epi32(~0x7F));
+      if (_mm_movemask_epi8(_mm_cmpeq_epi32(high_bits, _mm_setzero_si128())) ==
+          0xFFFF) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(w),
+                         _mm_packus_epi16(_mm_packs_epi32(a, b),
+                                          _mm_packs_epi32(c, d)));
+        i += 16;
+        w += 16;
+        continue;
+      }
+    }
+#endif
+    const uint32_t c = s[i];
+    if (c > 0x10FFFF || IsSurrogate(c)) {
+      TranscodeResult result = {false, i, static_cast<size_t>(w - out)};
+      return result;
+    }
+    ++i;
+    w = EncodeUtf8(c, w);
+  }
+  TranscodeResult result = {true, i, static_cast<size_t>(w - out)};
+  return result;
+}
+
+}  // namespace foundation
@@ -1,8 +1,292 @@
 
 #include <foundation/uuid/uuid.hpp>
 
-static int s_nextIdentifier = 0;
+#include <foundation/uuid/id_allocator.hpp>
 
-int getUuid() {
-  return s_nextIdentifier++;
+#include <stdint.h>
+#include <string.h>
+
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <thread>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <pthread.h>
+#define UUID_HAVE_PTHREAD_ATFORK 1
+#endif
+
+namespace foundation {
+
+namespace {
+
+// Bumped in a forked child so that its threads reseed rather than repeat
+// the parent's sequence.  Only ever read on the fast path.
+std::atomic<unsigned> g_fork_generation(0);
+
+#ifdef UUID_HAVE_PTHREAD_ATFORK
+void OnFork() {
+  g_fork_generation.fetch_add(1, std::memory_order_relaxed);
+}
+#endif
+
+inline uint64_t Rotl(uint64_t x, int k) {
+  return (x << k) | (x >> (64 - k));
+}
+
+// Per-thread generator state.
+class UuidGenerator {
+ public:
+  UuidGenerator() : generation_(~0u), last_ms_(0), counter_(0) {}
+
+  uint64_t Next() {
+    const unsigned generation =
+        g_fork_generation.load(std::memory_order_relaxed);
+    if (generation != generation_) {
+      Seed(generation);
+    }
+    // xoshiro256++
+    const uint64_t result = Rotl(s_[0] + s_[3], 23) + s_[0];
+    const uint64_t t = s_[1] << 17;
+    s_[2] ^= s_[0];
+    s_[3] ^= s_[1];
+    s_[1] ^= s_[2];
+    s_[0] ^= s_[3];
+    s_[2] ^= t;
+    s_[3] = Rotl(s_[3], 45);
+    return result;
+  }
+
+  // Returns the timestamp and 12-bit sequence for the next V7 ID from
+  // this thread, keeping (ms, counter) strictly increasing even if the
+  // clock steps backwards or 4096 IDs are taken in one millisecond.
+  void NextTime(uint64_t* ms, uint64_t* counter) {
+    const uint64_t now = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+    if (now > last_ms_) {
+      last_ms_ = now;
+      // Start low in the range so the counter rarely overflows.
+      counter_ = Next() & 0x3ff;
+    } else if (++counter_ > 0xfff) {
+      ++last_ms_;
+      counter_ = 0;
+    }
+    *ms = last_ms_;
+    *counter = counter_;
+  }
+
+ private:
+  void Seed(unsigned generation) {
+#ifdef UUID_HAVE_PTHREAD_ATFORK
+    static const int registered = pthread_atfork(NULL, NULL, OnFork);
+    (void)registered;
+#endif
+    std::random_device device;
+    for (int i = 0; i < 4; ++i) {
+      s_[i] = (static_cast<uint64_t>(device()) << 32) ^ device();
+    }
+    // Guard against a deterministic random_device.
+    s_[0] ^= static_cast<uint64_t>(
+        std::chrono::steady_clock::now().time_since_epoch().count());
+    s_[1] ^= std::hash<std::thread::id>()(std::this_thread::get_id());
+    if ((s_[0] | s_[1] | s_[2] | s_[3]) == 0) s_[0] = 1;
+    generation_ = generation;
+  }
+
+  uint64_t s_[4];
+  unsigned generation_;
+  uint64_t last_ms_;
+  uint64_t counter_;
+};
+
+UuidGenerator& ThreadGenerator() {
+  static thread_local UuidGenerator generator;
+  return generator;
+}
+
+const uint64_t kVariantMask = 0x3fffffffffffffffULL;
+const uint64_t kVariantBits = 0x8000000000000000ULL;
+
+const char kHexDigits[] = "0123456789abcdef";
+
+// Maps an ASCII hex digit to its value, anything else to 0xff.
+const unsigned char kHexValue[256] = {
+#define X 0xff
+  X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+  X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+  X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+  0, 1, 2, 3, 4, 5, 6, 7, 8, 9, X, X, X, X, X, X,
+  X, 10, 11, 12, 13, 14, 15, X, X, X, X, X, X, X, X, X,
+  X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+  X, 10, 11, 12, 13, 14, 15, X, X, X, X, X, X, X, X, X,
+  X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+  X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+  X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+  X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+  X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+  X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+  X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+  X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+  X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+#undef X
+};
+
+inline void StoreBigEndian64(uint64_t v, unsigned char* out) {
+  for (int i = 7; i >= 0; --i) {
+    out[i] = static_cast<unsigned char>(v);
+    v >>= 8;
+  }
+}
+
+inline uint64_t LoadBigEndian64(const unsigned char* in) {
+  uint64_t v = 0;
+  for (int i = 0; i < 8; ++i) v = (v << 8) | in[i];
+  return v;
+}
+
+// Converts 16 bytes to 32 lowercase hex digits.
+void BytesToHex(const unsigned char* bytes, char* hex) {
+#if defined(__SSE2__)
+  const __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes));
+  const __m128i mask = _mm_set1_epi8(0x0f);
+  const __m128i hi = _mm_and_si128(_mm_srli_epi16(in, 4), mask);
+  const __m128i lo = _mm_and_si128(in, mask);
+  // Digit d becomes '0' + d, plus ('a' - '0' - 10) when d > 9.
+  const __m128i nine = _mm_set1_epi8(9);
+  const __m128i zero = _mm_set1_epi8('0');
+  const __m128i gap = _mm_set1_epi8('a' - '0' - 10);
+  const __m128i hi_ascii = _mm_add_epi8(
+      _mm_add_epi8(hi, zero), _mm_and_si128(_mm_cmpgt_epi8(hi, nine), gap));
+  const __m128i lo_ascii = _mm_add_epi8(
+      _mm_add_epi8(lo, zero), _mm_and_si128(_mm_cmpgt_epi8(lo, nine), gap));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(hex),
+                   _mm_unpacklo_epi8(hi_ascii, lo_ascii));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(hex + 16),
+                   _mm_unpackhi_epi8(hi_ascii, lo_ascii));
+#else
+  for (int i = 0; i < 16; ++i) {
+    hex[2 * i] = kHexDigits[bytes[i] >> 4];
+    hex[2 * i + 1] = kHexDigits[bytes[i] & 0xf];
+  }
+#endif
+}
+
+// Converts 32 hex digits to 16 bytes.  Returns false on a non-hex digit.
+bool HexToBytes(const char* hex, unsigned char* bytes) {
+#if defined(__SSE2__)
+  bool ok = true;
+  for (int half = 0; half < 2; ++half) {
+    const __m128i in =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(hex + 16 * half));
+    // Digits: c - '0' in [0, 9].  Letters: (c | 0x20) - 'a' in [0, 5].
+    // Bytes are signed here, so biasing by 0x80 turns the unsigned range
+    // checks into signed compares.
+    const __m128i bias = _mm_set1_epi8(static_cast<char>(0x80));
+    const __m128i digit = _mm_sub_epi8(in, _mm_set1_epi8('0'));
+    const __m128i is_digit = _mm_cmplt_epi8(
+        _mm_xor_si128(digit, bias), _mm_set1_epi8(static_cast<char>(0x80 + 10)));
+    const __m128i letter = _mm_sub_epi8(
+        _mm_or_si128(in, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+    const __m128i is_letter = _mm_cmplt_epi8(
+        _mm_xor_si128(letter, bias), _mm_set1_epi8(static_cast<char>(0x80 + 6)));
+    if (_mm_movemask_epi8(_mm_or_si128(is_digit, is_letter)) != 0xffff) {
+      ok = false;
+      break;
+    }
+    const __m128i nibbles = _mm_or_si128(
+        _mm_and_si128(is_digit, digit),
+        _mm_and_si128(is_letter, _mm_add_epi8(letter, _mm_set1_epi8(10))));
+    // Each 16-bit lane holds (high nibble, low nibble) in memory order.
+    const __m128i packed = _mm_or_si128(
+        _mm_slli_epi16(_mm_and_si128(nibbles, _mm_set1_epi16(0x00ff)), 4),
+        _mm_srli_epi16(nibbles, 8));
+    const __m128i out = _mm_packus_epi16(packed, packed);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(bytes + 8 * half), out);
+  }
+  return ok;
+#else
+  for (int i = 0; i < 16; ++i) {
+    const unsigned char hi = kHexValue[static_cast<unsigned char>(hex[2 * i])];
+    const unsigned char lo =
+        kHexValue[static_cast<unsigned char>(hex[2 * i + 1])];
+    if ((hi | lo) == 0xff) return false;
+    bytes[i] = static_cast<unsigned char>((hi << 4) | lo);
+  }
+  return true;
+#endif
+}
+
+}  // namespace
+
+Uuid Uuid::GenerateV4() {
+  UuidGenerator& generator = ThreadGenerator();
+  const uint64_t high = generator.Next();
+  const uint64_t low = generator.Next();
+  return Uuid((high & ~0xf000ULL) | 0x4000ULL,
+              (low & kVariantMask) | kVariantBits);
+}
+
+Uuid Uuid::GenerateV7() {
+  UuidGenerator& generator = ThreadGenerator();
+  uint64_t ms, counter;
+  generator.NextTime(&ms, &counter);
+  const uint64_t high = (ms << 16) | 0x7000ULL | counter;
+  return Uuid(high, (generator.Next() & kVariantMask) | kVariantBits);
+}
+
+char* Uuid::Format(char* out) const {
+  unsigned char bytes[16];
+  StoreBigEndian64(high_, bytes);
+  StoreBigEndian64(low_, bytes + 8);
+  char hex[32];
+  BytesToHex(bytes, hex);
+  memcpy(out, hex, 8);
+  out[8] = '-';
+  memcpy(out + 9, hex + 8, 4);
+  out[13] = '-';
+  memcpy(out + 14, hex + 12, 4);
+  out[18] = '-';
+  memcpy(out + 19, hex + 16, 4);
+  out[23] = '-';
+  memcpy(out + 24, hex + 20, 12);
+  return out + kStringLength;
+}
+
+std::string Uuid::ToString() const {
+  char buffer[kStringLength];
+  Format(buffer);
+  return std::string(buffer, kStringLength);
+}
+
+bool Uuid::Parse(StringPiece text, Uuid* out) {
+  if (text.size() != static_cast<stringpiece_ssize_type>(kStringLength)) {
+    return false;
+  }
+  const char* p = text.data();
+  if (p[8] != '-' || p[13] != '-' || p[18] != '-' || p[23] != '-') {
+    return false;
+  }
+  char hex[32];
+  memcpy(hex, p, 8);
+  memcpy(hex + 8, p + 9, 4);
+  memcpy(hex + 12, p + 14, 4);
+  memcpy(hex + 16, p + 19, 4);
+  memcpy(hex + 20, p + 24, 12);
+  unsigned char bytes[16];
+  if (!HexToBytes(hex, bytes)) {
+    return false;
+  }
+  *out = Uuid(LoadBigEndian64(bytes), LoadBigEndian64(bytes + 8));
+  return true;
+}
+
+}  // namespace foundation
+
+uuid getUuid() {
+  return foundation::IdAllocator::Default()->Next();
 }